@@ -1,5 +1,15 @@
 // HelloWorldClient.cpp
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <thread>
 
@@ -8,11 +18,361 @@
 #endif
 
 #include <CommonAPI/CommonAPI.hpp>
+#include <CommonAPI/SomeIP/Address.hpp>
+#include <CommonAPI/SomeIP/InputStream.hpp>
+#include <CommonAPI/SomeIP/Message.hpp>
+#include <CommonAPI/SomeIP/OutputStream.hpp>
 #include <v0/commonapi/examples/HelloWorldProxy.hpp>
 
+#include "latency_histogram.hpp"
+
 using namespace v0::commonapi::examples;
 
-int main() {
+namespace {
+
+/**
+ * @brief 负载生成器：始终保持concurrency个sayHelloAsync调用在途，
+ * 每个调用成功时在回调中发起下一个，直到duration结束
+ * @note 失败的调用不在回调中重发(服务不可用时sayHelloAsync可能同步返回
+ * NOT_AVAILABLE，在回调中重发会递归)，而是由run()在kRetryBackoff之后重发
+ * @note 回调运行在CommonAPI的dispatch线程中，统计数据由mutex_保护
+ * @note 回调持有shared_ptr，对象在最后一个回调返回后才销毁
+ */
+class LoadGenerator : public std::enable_shared_from_this<LoadGenerator> {
+public:
+    LoadGenerator(std::shared_ptr<HelloWorldProxy<>> proxy, const std::string &name,
+            uint32_t concurrency, uint32_t timeout)
+        : proxy_(proxy), name_(name), concurrency_(concurrency > 0 ? concurrency : 1),
+          info_(timeout), timeout_(timeout), outstanding_(0), running_(false),
+          deferred_(0), seconds_(0), succeeded_(0), failed_(0), intervalCalls_(0) {
+    }
+
+    /**
+     * @brief Run for duration seconds and print calls/s and latency
+     * @param reportInterval 区间统计的输出周期，单位ms
+     */
+    void run(uint32_t duration, uint32_t reportInterval) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_ = std::chrono::steady_clock::now();
+        end_ = start_ + std::chrono::seconds(duration);
+        lastReport_ = start_;
+        running_ = true;
+        lock.unlock();
+        for (uint32_t i = 0; i < concurrency_; ++i)
+            call();
+        lock.lock();
+
+        while (std::chrono::steady_clock::now() < end_) {
+            std::chrono::steady_clock::time_point wakeup = std::min(end_,
+                    lastReport_ + std::chrono::milliseconds(reportInterval));
+            if (deferred_ > 0)
+                wakeup = std::min(wakeup, retryAt_);
+            condition_.wait_until(lock, wakeup);
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (deferred_ > 0 && now >= retryAt_ && now < end_) {
+                const uint32_t count = deferred_;
+                deferred_ = 0;
+                lock.unlock();
+                for (uint32_t i = 0; i < count; ++i)
+                    call();
+                lock.lock();
+            }
+            if (std::chrono::steady_clock::now() - lastReport_
+                    >= std::chrono::milliseconds(reportInterval))
+                printInterval();
+        }
+
+        // 不再发起新调用，等待在途调用完成或超时
+        running_ = false;
+        deferred_ = 0;
+        std::chrono::steady_clock::time_point drain = std::chrono::steady_clock::now()
+                + std::chrono::milliseconds(timeout_) + std::chrono::seconds(1);
+        condition_.wait_until(lock, drain, [this] { return outstanding_ == 0; });
+        seconds_ = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start_).count();
+
+        std::cout << "Calls: " << succeeded_ << " succeeded, " << failed_ << " failed";
+        for (std::map<int, uint64_t>::const_iterator it = failures_.begin();
+                it != failures_.end(); ++it)
+            std::cout << ", status " << it->first << ": " << it->second;
+        if (outstanding_ > 0)
+            std::cout << ", still outstanding: " << outstanding_;
+        std::cout << "\nThroughput: " << succeeded_ / seconds_ << " calls/s over "
+                << seconds_ << "s with concurrency " << concurrency_ << "\n";
+        std::cout << "Latency (total): ";
+        totalLatency_.print(std::cout);
+        std::cout << std::endl;
+    }
+
+    /**
+     * @brief Append the result of run() to path, with a header for a new file
+     * @note 列名与request_sample的CSV一致，binding_bench按列名读取两者
+     */
+    void writeCsv(const std::string &path, const std::string &label) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const bool isNew = !std::ifstream(path.c_str()).good();
+        std::ofstream csv(path.c_str(), std::ios::app);
+        if (!csv) {
+            std::cerr << "Couldn't open " << path << std::endl;
+            return;
+        }
+        if (isNew) {
+            csv << "label,transport,inflight,duration_s,requests,responses,failed,"
+                    "throughput_rps,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n";
+        }
+        const double us = 1000.0;
+        const double divisor = seconds_ > 0 ? seconds_ : 1.0;
+        csv << std::fixed << std::setprecision(3) << label << ",tcp," << concurrency_
+                << "," << seconds_ << ","
+                << succeeded_ + failed_ + outstanding_ << "," << succeeded_ << ","
+                << failed_ << "," << succeeded_ / divisor << ","
+                << totalLatency_.mean() / us << ","
+                << totalLatency_.percentile(50.0) / us << ","
+                << totalLatency_.percentile(90.0) / us << ","
+                << totalLatency_.percentile(99.0) / us << ","
+                << totalLatency_.percentile(99.9) / us << ","
+                << totalLatency_.max() / us << "\n";
+    }
+
+private:
+    void call() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            outstanding_++;
+        }
+        const std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+        std::shared_ptr<LoadGenerator> self = shared_from_this();
+        proxy_->sayHelloAsync(name_,
+                [self, sent](const CommonAPI::CallStatus &callStatus, const std::string &) {
+                    self->onReply(callStatus, sent);
+                }, &info_);
+    }
+
+    void onReply(const CommonAPI::CallStatus &callStatus,
+            std::chrono::steady_clock::time_point sent) {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        bool next = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            outstanding_--;
+            if (callStatus == CommonAPI::CallStatus::SUCCESS) {
+                const uint64_t latency = static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                now - sent).count());
+                intervalLatency_.record(latency);
+                totalLatency_.record(latency);
+                succeeded_++;
+                intervalCalls_++;
+            } else {
+                failed_++;
+                failures_[static_cast<int>(callStatus)]++;
+            }
+            if (running_ && now < end_) {
+                if (callStatus == CommonAPI::CallStatus::SUCCESS) {
+                    next = true;
+                } else {
+                    // 交给run()在退避之后重发
+                    if (deferred_++ == 0)
+                        retryAt_ = now + kRetryBackoff;
+                    condition_.notify_one();
+                }
+            }
+            if (outstanding_ == 0)
+                condition_.notify_one();
+        }
+        if (next)
+            call();
+    }
+
+    /// 调用者必须持有mutex_
+    void printInterval() {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - lastReport_).count();
+        std::cout << "Interval: " << intervalCalls_ / seconds << " calls/s, latency ";
+        intervalLatency_.print(std::cout);
+        std::cout << std::endl;
+        intervalLatency_.reset();
+        intervalCalls_ = 0;
+        lastReport_ = now;
+    }
+
+    /// 失败的调用重发前等待的时间
+    static const std::chrono::milliseconds kRetryBackoff;
+
+    std::shared_ptr<HelloWorldProxy<>> proxy_;
+    const std::string name_;
+    const uint32_t concurrency_;
+    /// 每个调用的超时时间
+    const CommonAPI::CallInfo info_;
+    const uint32_t timeout_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    uint32_t outstanding_;
+    bool running_;
+    /// 等待run()重发的失败调用数，以及最早的重发时间
+    uint32_t deferred_;
+    std::chrono::steady_clock::time_point retryAt_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point end_;
+    std::chrono::steady_clock::time_point lastReport_;
+    /// run()的实际时长，包括等待在途调用完成，单位s
+    double seconds_;
+    uint64_t succeeded_;
+    uint64_t failed_;
+    /// 按CallStatus统计的失败次数
+    std::map<int, uint64_t> failures_;
+    uint64_t intervalCalls_;
+    latency_histogram intervalLatency_;
+    latency_histogram totalLatency_;
+};
+
+const std::chrono::milliseconds LoadGenerator::kRetryBackoff(10);
+
+/**
+ * @brief 一次sayHello调用在绑定层的序列化开销：客户端写入name、服务端读出name、
+ * 服务端写入返回值、客户端读出返回值，部署参数与HelloWorld.fdepl一致
+ * @note 单线程循环iterations次，包括创建请求和响应Message，不包括发送和分发
+ * @param iterations 循环次数，不能为0
+ * @param requestBytes/responseBytes 输出序列化后请求和响应的payload字节数
+ * @return 每次调用的平均耗时，单位ns
+ */
+double measureSerialization(const std::string &name, const std::string &reply,
+        uint32_t iterations, uint32_t &requestBytes, uint32_t &responseBytes) {
+    // name为utf16le，返回值没有部署参数，使用默认的utf8
+    static const CommonAPI::SomeIP::StringDeployment nameDeployment(
+            0, 4, CommonAPI::SomeIP::StringEncoding::UTF16LE);
+    const CommonAPI::SomeIP::Address address(0x1234, 0x1234, 0, 1);
+    const CommonAPI::SomeIP::method_id_t method = 30000;
+
+    std::size_t sink = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        CommonAPI::SomeIP::Message call
+                = CommonAPI::SomeIP::Message::createMethodCall(address, method, true);
+        CommonAPI::SomeIP::OutputStream callOut(call, false);
+        callOut.writeValue(name, &nameDeployment);
+        callOut.flush();
+        std::string receivedName;
+        CommonAPI::SomeIP::InputStream callIn(call, false);
+        callIn.readValue(receivedName, &nameDeployment);
+
+        CommonAPI::SomeIP::Message response = call.createResponseMessage();
+        CommonAPI::SomeIP::OutputStream responseOut(response, false);
+        responseOut.writeValue(reply,
+                static_cast<const CommonAPI::SomeIP::StringDeployment *>(nullptr));
+        responseOut.flush();
+        std::string receivedReply;
+        CommonAPI::SomeIP::InputStream responseIn(response, false);
+        responseIn.readValue(receivedReply,
+                static_cast<const CommonAPI::SomeIP::StringDeployment *>(nullptr));
+
+        sink += receivedName.size() + receivedReply.size();
+        requestBytes = call.getBodyLength();
+        responseBytes = response.getBodyLength();
+    }
+    const std::chrono::steady_clock::duration elapsed
+            = std::chrono::steady_clock::now() - start;
+    if (sink == 0)
+        std::cerr << "unexpected empty output" << std::endl;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+} // namespace
+
+/**
+ * @note 默认每秒同步调用一次sayHello；--load时用sayHelloAsync保持
+ * --concurrency个调用在途，运行--duration秒后输出calls/s和延时分布
+ * @note --payload-size N使name序列化后的请求payload约为N字节。--csv时把
+ * 负载的结果追加到CSV；--serialize-only只测量序列化开销，不连接服务，
+ * 两者都供binding_bench使用
+ */
+int main(int argc, char **argv) {
+    bool loadMode = false;
+    bool serializeOnly = false;
+    uint32_t concurrency = 64;
+    uint32_t duration = 10; // Default: 10s
+    uint32_t reportInterval = 1000; // Default: 1s
+    uint32_t timeout = 1000; // Default: 1s
+    uint32_t payloadSize = 0; // Default: name "World"
+    uint32_t serializeIterations = 100000;
+    std::string csvPath;
+    std::string csvLabel = "commonapi";
+
+    std::string loadArg("--load");
+    std::string serializeOnlyArg("--serialize-only");
+    std::string concurrencyArg("--concurrency");
+    std::string durationArg("--duration");
+    std::string reportIntervalArg("--report-interval");
+    std::string timeoutArg("--timeout");
+    std::string payloadSizeArg("--payload-size");
+    std::string serializeIterationsArg("--serialize-iterations");
+    std::string csvArg("--csv");
+    std::string labelArg("--label");
+
+    for (int i = 1; i < argc; i++) {
+        uint32_t *number = nullptr;
+        if (loadArg == argv[i]) {
+            loadMode = true;
+        } else if (serializeOnlyArg == argv[i]) {
+            serializeOnly = true;
+        } else if (concurrencyArg == argv[i] && i + 1 < argc) {
+            number = &concurrency;
+        } else if (durationArg == argv[i] && i + 1 < argc) {
+            number = &duration;
+        } else if (reportIntervalArg == argv[i] && i + 1 < argc) {
+            number = &reportInterval;
+        } else if (timeoutArg == argv[i] && i + 1 < argc) {
+            number = &timeout;
+        } else if (payloadSizeArg == argv[i] && i + 1 < argc) {
+            number = &payloadSize;
+        } else if (serializeIterationsArg == argv[i] && i + 1 < argc) {
+            number = &serializeIterations;
+        } else if (csvArg == argv[i] && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (labelArg == argv[i] && i + 1 < argc) {
+            csvLabel = argv[++i];
+        }
+        if (number) {
+            i++;
+            std::stringstream converter;
+            converter << argv[i];
+            converter >> *number;
+        }
+    }
+
+    // utf16le字符串的payload：4字节长度、2字节BOM、每个字符2字节、2字节结束符
+    std::string name = "World";
+    if (payloadSize > 0) {
+        name.clear();
+        for (uint32_t i = 0; 2 * i + 8 < payloadSize; ++i)
+            name.push_back(static_cast<char>('a' + i % 26));
+    }
+
+    // 与HelloWorldStubImpl::sayHello的返回值相同
+    const std::string reply = "Hello " + name + "!";
+    if (serializeOnly) {
+        if (serializeIterations == 0) {
+            std::cerr << "--serialize-iterations must be at least 1" << std::endl;
+            return 1;
+        }
+        uint32_t requestBytes = 0, responseBytes = 0;
+        const double serializeNs = measureSerialization(name, reply, serializeIterations,
+                requestBytes, responseBytes);
+        std::cout << "Serialization: " << serializeNs << " ns/call, request "
+                << requestBytes << " bytes, response " << responseBytes << " bytes"
+                << std::endl;
+        if (!csvPath.empty()) {
+            const bool isNew = !std::ifstream(csvPath.c_str()).good();
+            std::ofstream csv(csvPath.c_str(), std::ios::app);
+            if (isNew)
+                csv << "label,payload_bytes,response_bytes,serialize_ns\n";
+            csv << std::fixed << std::setprecision(3) << csvLabel << "," << requestBytes
+                    << "," << responseBytes << "," << serializeNs << "\n";
+        }
+        return 0;
+    }
+
     CommonAPI::Runtime::setProperty("LogContext", "E01C");
     CommonAPI::Runtime::setProperty("LogApplication", "E01C");
     CommonAPI::Runtime::setProperty("LibraryBase", "HelloWorld");
@@ -32,15 +392,24 @@ int main() {
             instance, connection);
 
     std::cout << "Checking availability!" << std::endl;
+    // 等待期间的CPU时间会计入binding_bench的每次调用开销，不能忙等
     while (!myProxy->isAvailable())
-        std::this_thread::sleep_for(std::chrono::microseconds(10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     std::cout << "Available..." << std::endl;
 
-    const std::string name = "World";
+    if (loadMode) {
+        std::shared_ptr<LoadGenerator> generator = std::make_shared<LoadGenerator>(
+                myProxy, name, concurrency, timeout);
+        generator->run(duration, reportInterval);
+        if (!csvPath.empty())
+            generator->writeCsv(csvPath, csvLabel);
+        return 0;
+    }
+
     CommonAPI::CallStatus callStatus;
     std::string returnMessage;
 
-    CommonAPI::CallInfo info(1000);
+    CommonAPI::CallInfo info(timeout);
     info.sender_ = 1234;
 
     while (true) {
@@ -50,11 +419,10 @@ int main() {
             std::cerr << "Remote call failed!\n";
             return -1;
         }
-        info.timeout_ = info.timeout_ + 1000;
 
         std::cout << "Got message: '" << returnMessage << "'\n";
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 // HelloWorldService.cpp
 #include <iostream>
+#include <string>
 #include <thread>
 
 #include <CommonAPI/CommonAPI.hpp>
@@ -7,7 +8,14 @@
 
 using namespace std;
 
-int main() {
+int main(int argc, char **argv) {
+    bool quiet = false;
+    std::string quietArg("--quiet");
+    for (int i = 1; i < argc; i++) {
+        if (quietArg == argv[i])
+            quiet = true;
+    }
+
     CommonAPI::Runtime::setProperty("LogContext", "E01S");
     CommonAPI::Runtime::setProperty("LogApplication", "E01S");
     CommonAPI::Runtime::setProperty("LibraryBase", "HelloWorld");
@@ -18,7 +26,7 @@ int main() {
     std::string instance = "commonapi.examples.HelloWorld";
     std::string connection = "service-sample";
 
-    std::shared_ptr<HelloWorldStubImpl> myService = std::make_shared<HelloWorldStubImpl>();
+    std::shared_ptr<HelloWorldStubImpl> myService = std::make_shared<HelloWorldStubImpl>(quiet);
     bool successfullyRegistered = runtime->registerService(domain, instance, myService, connection);
 
     while (!successfullyRegistered) {
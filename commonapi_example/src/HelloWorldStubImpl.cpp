@@ -1,7 +1,7 @@
 // HelloWorldStubImpl.cpp
 #include "HelloWorldStubImpl.hpp"
 
-HelloWorldStubImpl::HelloWorldStubImpl() {
+HelloWorldStubImpl::HelloWorldStubImpl(bool _quiet) : quiet_(_quiet) {
 }
 
 HelloWorldStubImpl::~HelloWorldStubImpl() {
@@ -13,7 +13,8 @@ void HelloWorldStubImpl::sayHello(const std::shared_ptr<CommonAPI::ClientId> _cl
     std::stringstream messageStream;
 
     messageStream << "Hello " << _name << "!";
-    std::cout << "sayHello('" << _name << "'): '" << messageStream.str() << "'\n";
+    if (!quiet_)
+        std::cout << "sayHello('" << _name << "'): '" << messageStream.str() << "'\n";
 
     _reply(messageStream.str());
 };
\ No newline at end of file
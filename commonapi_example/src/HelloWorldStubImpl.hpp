@@ -8,10 +8,16 @@
 class HelloWorldStubImpl: public v0_1::commonapi::examples::HelloWorldStubDefault {
 
 public:
-    HelloWorldStubImpl();
+    /**
+     * @param _quiet 不打印每个调用，用于HelloWorldClient --load压测
+     */
+    HelloWorldStubImpl(bool _quiet = false);
     virtual ~HelloWorldStubImpl();
 
     virtual void sayHello(const std::shared_ptr<CommonAPI::ClientId> _client, std::string _name, sayHelloReply_t _return);
 
+private:
+    bool quiet_;
+
 };
 #endif /* HELLOWORLDSTUBIMPL_H_ */
\ No newline at end of file
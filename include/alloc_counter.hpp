@@ -0,0 +1,36 @@
+#ifndef VSOMEIP_EXAMPLES_ALLOC_COUNTER_HPP
+#define VSOMEIP_EXAMPLES_ALLOC_COUNTER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief 统计堆内存分配次数
+ * @note 全局operator new/delete的替换在src/alloc_counter.cpp中，只链接进需要
+ * 计数的可执行文件(response)；其他可执行文件包含本头文件时计数始终为0，
+ * 可以用is_installed()区分
+ * @note 计数同时包含vsomeip库内部的分配，按线程统计，便于测量某段代码的分配次数
+ */
+namespace alloc_counter {
+
+/// 当前线程累计的分配次数
+inline uint64_t &thread_allocations() {
+  static thread_local uint64_t its_count = 0;
+  return its_count;
+}
+
+/// 进程累计的分配次数
+inline std::atomic<uint64_t> &total_allocations() {
+  static std::atomic<uint64_t> its_count(0);
+  return its_count;
+}
+
+/// 链接了src/alloc_counter.cpp时为true，在静态初始化阶段设置
+inline bool &is_installed() {
+  static bool its_installed = false;
+  return its_installed;
+}
+
+} // namespace alloc_counter
+
+#endif // VSOMEIP_EXAMPLES_ALLOC_COUNTER_HPP
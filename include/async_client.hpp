@@ -0,0 +1,304 @@
+#ifndef VSOMEIP_EXAMPLES_ASYNC_CLIENT_HPP
+#define VSOMEIP_EXAMPLES_ASYNC_CLIENT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vsomeip/vsomeip.hpp"
+
+#include "timer_wheel.hpp"
+
+/**
+ * @brief 基于vsomeip::application的异步请求客户端
+ * @note send_async()发送请求后立即返回，响应按request id(client/session)
+ * 匹配到对应的调用，通过回调或std::future交付，一个线程可以同时驱动成千上万
+ * 个在途调用
+ * @note 所有者需要把on_message()注册为响应的message handler，并在自己的线程
+ * 中调用poll()处理超时和重试，两次调用的间隔不超过next_expiry()
+ * @note 没有响应的调用以合成的MT_ERROR消息结束：超时为E_TIMEOUT，
+ * cancel_all()为E_NOT_REACHABLE，见is_local_error()
+ * @note 超时后迟到的响应不属于任何调用，交给set_unmatched_handler()设置的
+ * 回调，例如释放响应中携带的资源
+ * @note 回调在不持有内部锁的情况下调用，可以在回调中再次调用send_async()；
+ * 回调运行在vsomeip的dispatcher线程或调用poll()/cancel_all()的线程中
+ */
+class async_client {
+public:
+  typedef std::function<void(const std::shared_ptr<vsomeip::message> &)>
+      response_handler_t;
+
+  /**
+   * @param _timeout 调用的超时时间，0表示不检查超时
+   * @param _retries 超时后最多重发的次数，每次重发使用新的session
+   */
+  async_client(std::shared_ptr<vsomeip::application> _app,
+               std::chrono::milliseconds _timeout, uint32_t _retries)
+      : app_(std::move(_app)), timeout_(_timeout), retries_(_retries),
+        retry_enabled_(true), deadlines_(std::chrono::milliseconds(1)),
+        sent_(0), completed_(0), unmatched_(0), retried_(0), timed_out_(0) {}
+
+  /**
+   * @brief Handle responses that match no pending call
+   * @note 必须在注册on_message()之前调用；回调在不持有内部锁的情况下调用
+   */
+  void set_unmatched_handler(response_handler_t _handler) {
+    unmatched_handler_ = std::move(_handler);
+  }
+
+  /**
+   * @brief Allow or suppress resending expired calls
+   * @note 停止或服务不可用时关闭，超时的调用直接以E_TIMEOUT结束
+   */
+  void set_retry_enabled(bool _enabled) {
+    retry_enabled_.store(_enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Send _request and call _handler with its response
+   * @note 重试时重发同一个message对象，调用完成前不能修改它；
+   * 同一个对象可以用于多个调用，但必须都通过本客户端发送
+   */
+  void send_async(const std::shared_ptr<vsomeip::message> &_request,
+                  response_handler_t _handler) {
+    std::vector<completion> its_completions;
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      send_locked(_request, std::move(_handler), 0, its_completions);
+    }
+    complete(its_completions);
+  }
+
+  /**
+   * @brief Send _request and return a future of its response
+   * @note 在future上阻塞的线程不能是调用poll()的线程，否则超时无法被处理
+   */
+  std::future<std::shared_ptr<vsomeip::message>>
+  send_async(const std::shared_ptr<vsomeip::message> &_request) {
+    auto its_promise =
+        std::make_shared<std::promise<std::shared_ptr<vsomeip::message>>>();
+    std::future<std::shared_ptr<vsomeip::message>> its_future =
+        its_promise->get_future();
+    send_async(_request,
+               [its_promise](
+                   const std::shared_ptr<vsomeip::message> &_response) {
+                 its_promise->set_value(_response);
+               });
+    return its_future;
+  }
+
+  /**
+   * @brief Complete the call matching _response
+   * @note 注册为响应的message handler
+   */
+  void on_message(const std::shared_ptr<vsomeip::message> &_response) {
+    response_handler_t its_handler;
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      auto its_call = calls_.find(_response->get_request());
+      if (its_call == calls_.end()) {
+        // 超时后迟到的响应，或者不是本客户端发送的请求
+        unmatched_++;
+      } else {
+        its_handler = std::move(its_call->second.handler_);
+        calls_.erase(its_call);
+        deadlines_.cancel(_response->get_request());
+        completed_++;
+      }
+    }
+    if (its_handler)
+      its_handler(_response);
+    else if (unmatched_handler_)
+      unmatched_handler_(_response);
+  }
+
+  /**
+   * @brief Retry or fail the calls whose deadline has passed
+   */
+  void poll() {
+    std::vector<completion> its_completions;
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      deadlines_.advance(std::chrono::steady_clock::now(),
+                         [this, &its_completions](vsomeip::request_t _request) {
+                           expire(_request, its_completions);
+                         });
+    }
+    complete(its_completions);
+  }
+
+  /**
+   * @brief Latest time for the next poll()
+   * @note 没有需要检查超时的调用时为time_point::max()
+   */
+  std::chrono::steady_clock::time_point next_expiry() const {
+    std::lock_guard<std::mutex> its_lock(mutex_);
+    return deadlines_.next_expiry();
+  }
+
+  /**
+   * @brief Fail all pending calls with E_NOT_REACHABLE
+   * @note 服务不可用后调用，在途请求不会再有响应
+   */
+  void cancel_all() {
+    std::vector<completion> its_completions;
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      for (auto &its_call : calls_)
+        its_completions.push_back(
+            {make_error(its_call.second.request_, its_call.first,
+                        vsomeip::return_code_e::E_NOT_REACHABLE),
+             std::move(its_call.second.handler_)});
+      calls_.clear();
+      deadlines_.clear();
+    }
+    complete(its_completions);
+  }
+
+  /**
+   * @brief Whether _response was synthesized by async_client
+   * @note 服务端也可能返回这两个返回码的错误响应，需要区分时不要依赖它
+   */
+  static bool
+  is_local_error(const std::shared_ptr<vsomeip::message> &_response) {
+    const vsomeip::return_code_e its_code = _response->get_return_code();
+    return _response->get_message_type() ==
+               vsomeip::message_type_e::MT_ERROR &&
+           (its_code == vsomeip::return_code_e::E_TIMEOUT ||
+            its_code == vsomeip::return_code_e::E_NOT_REACHABLE);
+  }
+
+  std::size_t pending() const {
+    std::lock_guard<std::mutex> its_lock(mutex_);
+    return calls_.size();
+  }
+
+  /// 发送的请求数，包括重发
+  uint64_t sent() const { return locked(sent_); }
+  /// 收到响应的调用数
+  uint64_t completed() const { return locked(completed_); }
+  uint64_t unmatched() const { return locked(unmatched_); }
+  uint64_t retried() const { return locked(retried_); }
+  /// 用完重试次数后以E_TIMEOUT结束的调用数
+  uint64_t timed_out() const { return locked(timed_out_); }
+
+private:
+  struct call {
+    std::shared_ptr<vsomeip::message> request_;
+    response_handler_t handler_;
+    /// 0表示第一次发送
+    uint32_t attempt_;
+  };
+
+  /// 释放锁之后才调用的回调
+  struct completion {
+    std::shared_ptr<vsomeip::message> response_;
+    response_handler_t handler_;
+  };
+
+  /**
+   * @brief Send _request and register the call under its request id
+   * @note 发送和登记在同一个锁内完成，响应不会早于登记到达on_message()
+   * @note 调用者必须持有mutex_
+   */
+  void send_locked(const std::shared_ptr<vsomeip::message> &_request,
+                   response_handler_t _handler, uint32_t _attempt,
+                   std::vector<completion> &_completions) {
+    /**
+     * @brief Send a message
+     *
+     * @note 对于消息中的request_id，其会自动使用client_id和session_id进行拼装
+     */
+    app_->send(_request);
+    sent_++;
+    const vsomeip::request_t its_request = _request->get_request();
+    auto its_call = calls_.find(its_request);
+    if (its_call != calls_.end()) {
+      // session回绕后与仍在途的调用冲突，旧调用的响应已经无法区分
+      timed_out_++;
+      _completions.push_back({make_error(its_call->second.request_, its_request,
+                                         vsomeip::return_code_e::E_TIMEOUT),
+                              std::move(its_call->second.handler_)});
+      calls_.erase(its_call);
+    }
+    calls_.emplace(its_request, call{_request, std::move(_handler), _attempt});
+    if (timeout_.count() > 0)
+      deadlines_.schedule(its_request,
+                          std::chrono::steady_clock::now() + timeout_);
+  }
+
+  /**
+   * @brief Resend an expired call or fail it with E_TIMEOUT
+   * @note 调用者必须持有mutex_
+   */
+  void expire(vsomeip::request_t _request,
+              std::vector<completion> &_completions) {
+    auto its_call = calls_.find(_request);
+    if (its_call == calls_.end())
+      return;
+    call its_expired = std::move(its_call->second);
+    calls_.erase(its_call);
+    if (its_expired.attempt_ < retries_ &&
+        retry_enabled_.load(std::memory_order_relaxed)) {
+      retried_++;
+      send_locked(its_expired.request_, std::move(its_expired.handler_),
+                  its_expired.attempt_ + 1, _completions);
+      return;
+    }
+    timed_out_++;
+    _completions.push_back({make_error(its_expired.request_, _request,
+                                       vsomeip::return_code_e::E_TIMEOUT),
+                            std::move(its_expired.handler_)});
+  }
+
+  /**
+   * @brief Synthesize the error response of a call without response
+   * @note 与服务端返回的错误响应形式相同，调用者可以用同一种方式处理
+   */
+  static std::shared_ptr<vsomeip::message>
+  make_error(const std::shared_ptr<vsomeip::message> &_request,
+             vsomeip::request_t _id, vsomeip::return_code_e _code) {
+    std::shared_ptr<vsomeip::message> its_error =
+        vsomeip::runtime::get()->create_response(_request);
+    its_error->set_client(static_cast<vsomeip::client_t>(_id >> 16));
+    its_error->set_session(static_cast<vsomeip::session_t>(_id & 0xFFFF));
+    its_error->set_message_type(vsomeip::message_type_e::MT_ERROR);
+    its_error->set_return_code(_code);
+    return its_error;
+  }
+
+  static void complete(std::vector<completion> &_completions) {
+    for (completion &its_completion : _completions)
+      its_completion.handler_(its_completion.response_);
+  }
+
+  uint64_t locked(const uint64_t &_counter) const {
+    std::lock_guard<std::mutex> its_lock(mutex_);
+    return _counter;
+  }
+
+  std::shared_ptr<vsomeip::application> app_;
+  const std::chrono::milliseconds timeout_;
+  const uint32_t retries_;
+  std::atomic<bool> retry_enabled_;
+  response_handler_t unmatched_handler_;
+  mutable std::mutex mutex_;
+  /// 在途调用(request id -> 调用)，受mutex_保护
+  std::unordered_map<vsomeip::request_t, call> calls_;
+  /// calls_中调用的截止时间，受mutex_保护
+  timer_wheel<vsomeip::request_t> deadlines_;
+  uint64_t sent_;
+  uint64_t completed_;
+  uint64_t unmatched_;
+  uint64_t retried_;
+  uint64_t timed_out_;
+};
+
+#endif // VSOMEIP_EXAMPLES_ASYNC_CLIENT_HPP
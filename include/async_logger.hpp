@@ -0,0 +1,348 @@
+#ifndef VSOMEIP_EXAMPLES_ASYNC_LOGGER_HPP
+#define VSOMEIP_EXAMPLES_ASYNC_LOGGER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <vsomeip/vsomeip.hpp>
+
+#include "message_formatter.hpp"
+
+/**
+ * @brief 日志级别，低于当前级别的日志在调用处直接丢弃
+ */
+enum class log_level_e : uint8_t {
+  LL_DEBUG = 0,
+  LL_INFO = 1,
+  LL_WARNING = 2,
+  LL_ERROR = 3,
+  LL_NONE = 4,
+};
+
+/**
+ * @brief 异步日志
+ * @note 调用线程只把消息头的原始字段拷贝到本线程的无锁环形缓冲区(SPSC)中，
+ * 格式化和输出都在后台线程完成，消息处理线程不会因为输出而阻塞
+ * @note 缓冲区满时丢弃新日志并计数，不会阻塞调用者
+ * @note 没有日志时后台线程在条件变量上休眠，只有它休眠时写日志的线程才会
+ * 唤醒它，空闲时不轮询
+ */
+class async_logger {
+public:
+  /// 每条日志最多记录的payload字节数
+  static constexpr std::size_t kPayloadPrefix = 32;
+  /// 文本日志的最大长度
+  static constexpr std::size_t kTextLength = 96;
+
+  static async_logger &get() {
+    static async_logger its_logger;
+    return its_logger;
+  }
+
+  void set_level(log_level_e _level) {
+    level_.store(_level, std::memory_order_relaxed);
+  }
+
+  bool is_enabled(log_level_e _level) const {
+    return _level >= level_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Log the header fields of a message
+   * @param _what 日志前缀，必须是字符串常量，只保存指针
+   * @param _with_payload 是否同时记录payload(最多kPayloadPrefix字节)
+   */
+  void log_message(log_level_e _level, const char *_what,
+                   const std::shared_ptr<vsomeip::message> &_message,
+                   bool _with_payload = false) {
+    if (!is_enabled(_level))
+      return;
+    record *its_record = local_ring().reserve();
+    if (!its_record) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    its_record->timestamp_ = now();
+    its_record->level_ = _level;
+    its_record->kind_ = _with_payload ? kind_e::HEADER_PAYLOAD : kind_e::HEADER;
+    its_record->what_ = _what;
+    its_record->header_ = message_header::from(*_message);
+    its_record->payload_length_ = 0;
+    if (_with_payload) {
+      std::shared_ptr<vsomeip::payload> its_payload = _message->get_payload();
+      its_record->payload_length_ = its_payload->get_length();
+      std::memcpy(its_record->payload_, its_payload->get_data(),
+                  std::min<std::size_t>(its_record->payload_length_,
+                                        kPayloadPrefix));
+    }
+    local_ring().commit();
+    wake();
+  }
+
+  /**
+   * @brief Log a short text, longer texts are truncated
+   */
+  void log_text(log_level_e _level, const char *_text) {
+    if (!is_enabled(_level))
+      return;
+    record *its_record = local_ring().reserve();
+    if (!its_record) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    its_record->timestamp_ = now();
+    its_record->level_ = _level;
+    its_record->kind_ = kind_e::TEXT;
+    std::strncpy(its_record->text_, _text, kTextLength - 1);
+    its_record->text_[kTextLength - 1] = '\0';
+    local_ring().commit();
+    wake();
+  }
+
+  /// 因缓冲区满而丢弃的日志数
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Write everything logged so far before returning
+   */
+  void flush() {
+    std::lock_guard<std::mutex> its_lock(drain_mutex_);
+    drain();
+  }
+
+  ~async_logger() {
+    {
+      std::lock_guard<std::mutex> its_lock(wakeup_mutex_);
+      running_ = false;
+    }
+    wakeup_.notify_one();
+    if (worker_.joinable())
+      worker_.join();
+    flush();
+  }
+
+private:
+  enum class kind_e : uint8_t { TEXT, HEADER, HEADER_PAYLOAD };
+
+  struct record {
+    uint64_t timestamp_;
+    log_level_e level_;
+    kind_e kind_;
+    const char *what_;
+    message_header header_;
+    uint32_t payload_length_;
+    union {
+      vsomeip::byte_t payload_[kPayloadPrefix];
+      char text_[kTextLength];
+    };
+  };
+
+  /**
+   * @brief 单生产者单消费者的环形缓冲区，每个写日志的线程一个
+   */
+  class ring {
+  public:
+    static constexpr std::size_t kCapacity = 1024; // must be a power of two
+
+    ring() : records_(kCapacity), head_(0), tail_(0) {}
+
+    /// 生产者：获取下一个可写的位置，缓冲区满时返回nullptr
+    record *reserve() {
+      const std::size_t its_tail = tail_.load(std::memory_order_relaxed);
+      if (its_tail - head_.load(std::memory_order_acquire) == kCapacity)
+        return nullptr;
+      return &records_[its_tail & (kCapacity - 1)];
+    }
+    /// 生产者：发布reserve()返回的记录
+    void commit() { tail_.fetch_add(1, std::memory_order_release); }
+
+    /// 消费者：依次处理所有已发布的记录
+    template <typename Fn> std::size_t consume(Fn &&_fn) {
+      const std::size_t its_head = head_.load(std::memory_order_relaxed);
+      const std::size_t its_tail = tail_.load(std::memory_order_acquire);
+      for (std::size_t i = its_head; i != its_tail; ++i)
+        _fn(records_[i & (kCapacity - 1)]);
+      head_.store(its_tail, std::memory_order_release);
+      return its_tail - its_head;
+    }
+
+  private:
+    std::vector<record> records_;
+    alignas(64) std::atomic<std::size_t> head_;
+    alignas(64) std::atomic<std::size_t> tail_;
+  };
+
+  async_logger()
+      : level_(log_level_e::LL_INFO), dropped_(0), reported_dropped_(0),
+        start_(std::chrono::steady_clock::now()), sleeping_(false),
+        running_(true), worker_(&async_logger::run, this) {}
+
+  uint64_t now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start_)
+        .count();
+  }
+
+  /// 当前线程的缓冲区，第一次使用时注册到后台线程
+  ring &local_ring() {
+    static thread_local std::shared_ptr<ring> its_ring;
+    if (!its_ring) {
+      its_ring = std::make_shared<ring>();
+      std::lock_guard<std::mutex> its_lock(rings_mutex_);
+      rings_.push_back(its_ring);
+    }
+    return *its_ring;
+  }
+
+  /**
+   * @brief Wake the worker if it is sleeping
+   * @note 与run()中的fence配对：要么生产者看到sleeping_，要么后台线程在
+   * 休眠前看到刚提交的记录
+   */
+  void wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!sleeping_.load(std::memory_order_relaxed))
+      return;
+    {
+      std::lock_guard<std::mutex> its_lock(wakeup_mutex_);
+      sleeping_.store(false, std::memory_order_relaxed);
+    }
+    wakeup_.notify_one();
+  }
+
+  std::size_t drain_locked() {
+    std::lock_guard<std::mutex> its_lock(drain_mutex_);
+    return drain();
+  }
+
+  /**
+   * @brief Worker loop: drain while there are records, otherwise sleep
+   * @note 丢弃计数和已退出线程的缓冲区不会唤醒后台线程，
+   * 休眠最多kIdleWait后也会处理一次
+   */
+  void run() {
+    {
+      std::lock_guard<std::mutex> its_lock(drain_mutex_);
+      buffer_.reserve(64 * 1024);
+    }
+    while (running_) {
+      if (drain_locked() > 0)
+        continue;
+      sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (drain_locked() == 0) {
+        std::unique_lock<std::mutex> its_lock(wakeup_mutex_);
+        wakeup_.wait_for(its_lock, kIdleWait, [this] {
+          return !sleeping_.load(std::memory_order_relaxed) || !running_;
+        });
+      }
+      sleeping_.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  /// 格式化并输出所有缓冲区中的日志，调用者必须持有drain_mutex_
+  std::size_t drain() {
+    std::vector<std::shared_ptr<ring>> its_rings;
+    {
+      std::lock_guard<std::mutex> its_lock(rings_mutex_);
+      // 线程退出后其缓冲区只被rings_引用，处理完剩余日志后移除
+      for (auto it = rings_.begin(); it != rings_.end();) {
+        const bool is_orphan = (it->use_count() == 1);
+        its_rings.push_back(*it);
+        it = is_orphan ? rings_.erase(it) : it + 1;
+      }
+    }
+    std::size_t its_count = 0;
+    for (auto &its_ring : its_rings) {
+      its_count += its_ring->consume([this](const record &_record) {
+        format(_record);
+        if (buffer_.size() > 60 * 1024)
+          write_buffer();
+      });
+    }
+    const uint64_t its_dropped = dropped();
+    if (its_dropped != reported_dropped_) {
+      formatter_.clear();
+      formatter_.append("[async_logger] dropped ")
+          .append_dec(its_dropped - reported_dropped_)
+          .append(" records, buffer full\n");
+      append(formatter_.view());
+      reported_dropped_ = its_dropped;
+    }
+    write_buffer();
+    return its_count;
+  }
+
+  void append(std::string_view _text) {
+    buffer_.append(_text.data(), _text.size());
+  }
+
+  void format(const record &_record) {
+    formatter_.clear();
+    const uint64_t its_us = _record.timestamp_ / 1000;
+    formatter_.append('[').append_dec(its_us / 1000000).append('.');
+    const uint64_t its_fraction = its_us % 1000000;
+    for (uint64_t its_digit = 100000; its_digit > its_fraction && its_digit > 1;
+         its_digit /= 10)
+      formatter_.append('0');
+    formatter_.append_dec(its_fraction).append("] ");
+    if (_record.kind_ == kind_e::TEXT) {
+      formatter_.append(_record.text_);
+    } else {
+      formatter_.append_header(_record.what_, _record.header_);
+      if (_record.kind_ == kind_e::HEADER_PAYLOAD) {
+        formatter_.append_payload(
+            _record.payload_,
+            std::min<std::size_t>(_record.payload_length_, kPayloadPrefix),
+            _record.payload_length_);
+      }
+    }
+    formatter_.append('\n');
+    append(formatter_.view());
+  }
+
+  void write_buffer() {
+    if (buffer_.empty())
+      return;
+    std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+    std::fflush(stdout);
+    buffer_.clear();
+  }
+
+  std::atomic<log_level_e> level_;
+  std::atomic<uint64_t> dropped_;
+  uint64_t reported_dropped_;
+  const std::chrono::steady_clock::time_point start_;
+
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<ring>> rings_;
+
+  /// 只在持有drain_mutex_时使用
+  std::mutex drain_mutex_;
+  std::string buffer_;
+  message_formatter formatter_;
+
+  /// 后台线程没有日志可处理时的最长休眠时间
+  static constexpr std::chrono::milliseconds kIdleWait{100};
+
+  /// 后台线程正在或即将休眠
+  std::atomic<bool> sleeping_;
+  std::mutex wakeup_mutex_;
+  std::condition_variable wakeup_;
+
+  std::atomic<bool> running_;
+  std::thread worker_;
+};
+
+#endif // VSOMEIP_EXAMPLES_ASYNC_LOGGER_HPP
@@ -0,0 +1,140 @@
+#ifndef VSOMEIP_EXAMPLES_BATCH_CODEC_HPP
+#define VSOMEIP_EXAMPLES_BATCH_CODEC_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vsomeip/vsomeip.hpp>
+
+/**
+ * @brief 把多个小样本打包进一个event payload的帧格式
+ * @note 格式为4字节magic + 4字节样本数，之后每个样本为4字节长度 + 数据，
+ * 均为大端
+ */
+namespace batch_codec {
+
+/// "BAT1"
+constexpr uint32_t kMagic = 0x42415431;
+constexpr std::size_t kHeaderSize = 8;
+constexpr std::size_t kFrameHeaderSize = 4;
+
+namespace detail {
+
+inline void write_u32(vsomeip::byte_t *_data, uint32_t _value) {
+  for (int i = 3; i >= 0; --i) {
+    _data[i] = static_cast<vsomeip::byte_t>(_value & 0xFF);
+    _value >>= 8;
+  }
+}
+
+inline uint32_t read_u32(const vsomeip::byte_t *_data) {
+  uint32_t its_value = 0;
+  for (int i = 0; i < 4; ++i)
+    its_value = (its_value << 8) | _data[i];
+  return its_value;
+}
+
+} // namespace detail
+
+/**
+ * @brief 累积样本，直到样本数、字节数或第一个样本的等待时间达到上限
+ * @note 非线程安全，每个event使用一个
+ */
+class encoder {
+public:
+  /**
+   * @param _max_count 一个batch最多包含的样本数
+   * @param _max_bytes 一个batch的最大字节数(包括帧头)，单个更大的样本单独发送
+   * @param _max_delay 第一个样本加入后最多等待的时间
+   */
+  encoder(uint32_t _max_count, std::size_t _max_bytes,
+          std::chrono::microseconds _max_delay)
+      : max_count_(_max_count > 0 ? _max_count : 1), max_bytes_(_max_bytes),
+        max_delay_(_max_delay), count_(0) {
+    buffer_.reserve(max_bytes_);
+    reset();
+  }
+
+  bool empty() const { return count_ == 0; }
+  uint32_t count() const { return count_; }
+
+  /// 加入_length字节的样本后是否会超过字节数上限
+  bool would_overflow(std::size_t _length) const {
+    return buffer_.size() + kFrameHeaderSize + _length > max_bytes_;
+  }
+
+  bool is_full() const { return count_ >= max_count_; }
+
+  /// 第一个样本是否已经等待了_max_delay
+  bool is_overdue(std::chrono::steady_clock::time_point _now) const {
+    return count_ > 0 && _now - first_ >= max_delay_;
+  }
+
+  /// 最早需要因超时发送的时间，batch为空时没有意义
+  std::chrono::steady_clock::time_point deadline() const {
+    return first_ + max_delay_;
+  }
+
+  void add(const vsomeip::byte_t *_data, std::size_t _length,
+           std::chrono::steady_clock::time_point _now) {
+    if (count_ == 0)
+      first_ = _now;
+    const std::size_t its_offset = buffer_.size();
+    buffer_.resize(its_offset + kFrameHeaderSize + _length);
+    detail::write_u32(&buffer_[its_offset], static_cast<uint32_t>(_length));
+    std::copy(_data, _data + _length,
+              buffer_.begin() + its_offset + kFrameHeaderSize);
+    count_++;
+    detail::write_u32(&buffer_[4], count_);
+  }
+
+  const vsomeip::byte_t *data() const { return buffer_.data(); }
+  std::size_t size() const { return buffer_.size(); }
+
+  /// 发送后清空，保留已分配的内存
+  void reset() {
+    buffer_.resize(kHeaderSize);
+    detail::write_u32(&buffer_[0], kMagic);
+    detail::write_u32(&buffer_[4], 0);
+    count_ = 0;
+  }
+
+private:
+  const uint32_t max_count_;
+  const std::size_t max_bytes_;
+  const std::chrono::microseconds max_delay_;
+  uint32_t count_;
+  std::chrono::steady_clock::time_point first_;
+  std::vector<vsomeip::byte_t> buffer_;
+};
+
+/**
+ * @brief Call _func(data, length) for every sample in a batch payload
+ * @return false if the payload is not a well-formed batch; samples before
+ * the malformed frame have already been passed to _func
+ */
+template <typename F>
+bool for_each(const vsomeip::byte_t *_data, std::size_t _length, F &&_func) {
+  if (_length < kHeaderSize || detail::read_u32(_data) != kMagic)
+    return false;
+  const uint32_t its_count = detail::read_u32(_data + 4);
+  std::size_t its_offset = kHeaderSize;
+  for (uint32_t i = 0; i < its_count; ++i) {
+    if (_length - its_offset < kFrameHeaderSize)
+      return false;
+    const uint32_t its_size = detail::read_u32(_data + its_offset);
+    its_offset += kFrameHeaderSize;
+    if (_length - its_offset < its_size)
+      return false;
+    _func(_data + its_offset, static_cast<std::size_t>(its_size));
+    its_offset += its_size;
+  }
+  return its_offset == _length;
+}
+
+} // namespace batch_codec
+
+#endif // VSOMEIP_EXAMPLES_BATCH_CODEC_HPP
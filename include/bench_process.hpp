@@ -0,0 +1,148 @@
+#ifndef VSOMEIP_EXAMPLES_BENCH_PROCESS_HPP
+#define VSOMEIP_EXAMPLES_BENCH_PROCESS_HPP
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief 基准测试驱动程序(someip_bench、startup_sweep、binding_bench)启动和
+ * 回收示例进程的公共函数
+ */
+namespace bench_process {
+
+template <typename T> std::vector<T> parse_list(const std::string &_list) {
+  std::vector<T> its_values;
+  std::stringstream its_stream(_list);
+  std::string its_item;
+  while (std::getline(its_stream, its_item, ',')) {
+    if (its_item.empty())
+      continue;
+    std::stringstream converter;
+    converter << its_item;
+    T its_value;
+    if (converter >> its_value)
+      its_values.push_back(its_value);
+  }
+  return its_values;
+}
+
+/// CSV一行中按列名取值，列不存在或为空时返回-1
+inline double csv_column(const std::string &_header, const std::string &_row,
+                         const std::string &_name) {
+  std::stringstream its_names(_header), its_values(_row);
+  std::string its_name, its_value;
+  while (std::getline(its_names, its_name, ',') &&
+         std::getline(its_values, its_value, ',')) {
+    if (its_name != _name)
+      continue;
+    std::stringstream converter;
+    converter << its_value;
+    double its_result = -1;
+    return (converter >> its_result) ? its_result : -1;
+  }
+  return -1;
+}
+
+/// 默认在本程序所在的目录中查找routing/request/response
+inline std::string executable_dir() {
+  char its_path[PATH_MAX];
+  const ssize_t its_length =
+      readlink("/proc/self/exe", its_path, sizeof(its_path) - 1);
+  if (its_length <= 0)
+    return ".";
+  std::string its_result(its_path, static_cast<std::size_t>(its_length));
+  const std::string::size_type its_slash = its_result.rfind('/');
+  return its_slash == std::string::npos ? "." : its_result.substr(0, its_slash);
+}
+
+/**
+ * @brief Start _binary with VSOMEIP_CONFIGURATION set to _config
+ * @note 子进程的stdout/stderr追加到_log
+ * @return 子进程的pid，失败时返回-1
+ */
+inline pid_t spawn(const std::string &_binary,
+                   const std::vector<std::string> &_args,
+                   const std::string &_config, const std::string &_log) {
+  const pid_t its_pid = fork();
+  if (its_pid != 0) {
+    if (its_pid < 0)
+      std::cerr << "fork failed: " << std::strerror(errno) << std::endl;
+    return its_pid;
+  }
+
+  setenv("VSOMEIP_CONFIGURATION", _config.c_str(), 1);
+  const int its_log = open(_log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (its_log >= 0) {
+    dup2(its_log, STDOUT_FILENO);
+    dup2(its_log, STDERR_FILENO);
+    close(its_log);
+  }
+  std::vector<char *> its_argv;
+  its_argv.push_back(const_cast<char *>(_binary.c_str()));
+  for (const std::string &its_arg : _args)
+    its_argv.push_back(const_cast<char *>(its_arg.c_str()));
+  its_argv.push_back(nullptr);
+  execv(_binary.c_str(), its_argv.data());
+  std::cerr << "Couldn't start " << _binary << ": " << std::strerror(errno)
+            << std::endl;
+  _exit(127);
+}
+
+/// 进程退出后的用户态+内核态CPU时间，单位s
+inline double cpu_seconds(const rusage &_usage) {
+  auto seconds = [](const timeval &_time) {
+    return static_cast<double>(_time.tv_sec) +
+           static_cast<double>(_time.tv_usec) / 1e6;
+  };
+  return seconds(_usage.ru_utime) + seconds(_usage.ru_stime);
+}
+
+/**
+ * @brief Wait up to _timeout for _pid to exit
+ * @param _cpu 进程退出时加上它消耗的CPU时间，单位s
+ * @return true if the process exited
+ */
+inline bool wait_for(pid_t _pid, std::chrono::milliseconds _timeout,
+                     double &_cpu) {
+  const auto its_deadline = std::chrono::steady_clock::now() + _timeout;
+  do {
+    int its_status = 0;
+    rusage its_usage;
+    const pid_t its_result = wait4(_pid, &its_status, WNOHANG, &its_usage);
+    if (its_result == _pid)
+      _cpu += cpu_seconds(its_usage);
+    if (its_result == _pid || (its_result < 0 && errno == ECHILD))
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  } while (std::chrono::steady_clock::now() < its_deadline);
+  return false;
+}
+
+/// 先发送SIGINT让vsomeip正常退出，超时后强制结束
+inline void terminate(pid_t _pid, double &_cpu) {
+  if (_pid <= 0)
+    return;
+  kill(_pid, SIGINT);
+  if (!wait_for(_pid, std::chrono::seconds(3), _cpu)) {
+    kill(_pid, SIGKILL);
+    wait_for(_pid, std::chrono::seconds(3), _cpu);
+  }
+}
+
+} // namespace bench_process
+
+#endif // VSOMEIP_EXAMPLES_BENCH_PROCESS_HPP
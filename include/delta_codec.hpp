@@ -0,0 +1,241 @@
+#ifndef VSOMEIP_EXAMPLES_DELTA_CODEC_HPP
+#define VSOMEIP_EXAMPLES_DELTA_CODEC_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vsomeip/vsomeip.hpp>
+
+/**
+ * @brief field值的增量编码：只发送与上一次发送的值相比变化的字节范围，
+ * 周期性地发送完整值(keyframe)
+ * @note 帧格式(大端)：4字节magic + 1字节类型 + 4字节序号 + 4字节基准序号 +
+ * 4字节完整值长度。keyframe之后是完整值；delta之后是若干个
+ * 4字节偏移 + 4字节长度 + 数据，基准序号是它所依赖的帧的序号
+ */
+namespace delta_codec {
+
+/// "DLT1"
+constexpr uint32_t kMagic = 0x444C5431;
+constexpr std::size_t kHeaderSize = 17;
+constexpr std::size_t kRangeHeaderSize = 8;
+
+enum class frame_type_e : uint8_t { FT_KEYFRAME = 0, FT_DELTA = 1 };
+
+namespace detail {
+
+inline void write_u32(std::vector<vsomeip::byte_t> &_buffer, uint32_t _value) {
+  for (int i = 3; i >= 0; --i)
+    _buffer.push_back(static_cast<vsomeip::byte_t>(_value >> (8 * i)));
+}
+
+inline uint32_t read_u32(const vsomeip::byte_t *_data) {
+  uint32_t its_value = 0;
+  for (int i = 0; i < 4; ++i)
+    its_value = (its_value << 8) | _data[i];
+  return its_value;
+}
+
+} // namespace detail
+
+/**
+ * @brief Encode successive values of one field
+ * @note 非线程安全，调用者负责与notify串行化
+ */
+class encoder {
+public:
+  /**
+   * @param _keyframe_interval 每N帧至少发送一次keyframe，0表示只在第一帧和
+   * force_keyframe()之后发送
+   */
+  explicit encoder(uint32_t _keyframe_interval)
+      : keyframe_interval_(_keyframe_interval), sequence_(0),
+        since_keyframe_(0), has_base_(false), keyframes_(0), deltas_(0),
+        encoded_bytes_(0), full_bytes_(0) {}
+
+  /// 下一帧发送keyframe，用于接收端请求重新同步
+  void force_keyframe() { has_base_ = false; }
+
+  /**
+   * @brief Encode _value against the last encoded value
+   * @note delta不比keyframe小时发送keyframe
+   * @return 编码后的帧，在下一次调用前有效
+   */
+  const std::vector<vsomeip::byte_t> &encode(const vsomeip::byte_t *_value,
+                                             std::size_t _length) {
+    const uint32_t its_base = sequence_;
+    sequence_++;
+    const bool is_keyframe =
+        !has_base_ ||
+        (keyframe_interval_ > 0 && since_keyframe_ + 1 >= keyframe_interval_) ||
+        !encode_delta(its_base, _value, _length);
+    if (is_keyframe) {
+      write_header(frame_type_e::FT_KEYFRAME, sequence_, _length);
+      frame_.insert(frame_.end(), _value, _value + _length);
+      since_keyframe_ = 0;
+      keyframes_++;
+    } else {
+      since_keyframe_++;
+      deltas_++;
+    }
+    base_.assign(_value, _value + _length);
+    has_base_ = true;
+    encoded_bytes_ += frame_.size();
+    full_bytes_ += _length;
+    return frame_;
+  }
+
+  uint64_t keyframes() const { return keyframes_; }
+  uint64_t deltas() const { return deltas_; }
+  /// 编码后的总字节数，与full_bytes()比较得到节省的带宽
+  uint64_t encoded_bytes() const { return encoded_bytes_; }
+  uint64_t full_bytes() const { return full_bytes_; }
+
+private:
+  /**
+   * @brief Write a delta of _value against base_ into frame_
+   * @return false if a keyframe would not be larger
+   */
+  bool encode_delta(uint32_t _base, const vsomeip::byte_t *_value,
+                    std::size_t _length) {
+    write_header(frame_type_e::FT_DELTA, _base, _length);
+    const std::size_t its_common = std::min(_length, base_.size());
+    std::size_t i = 0;
+    while (i < _length) {
+      if (i < its_common && _value[i] == base_[i]) {
+        ++i;
+        continue;
+      }
+      // 相距不超过一个范围头的未变化字节并入同一个范围，比新开一个范围更小
+      std::size_t its_end = i + 1;
+      std::size_t its_unchanged = 0;
+      for (std::size_t j = its_end; j < _length; ++j) {
+        if (j < its_common && _value[j] == base_[j]) {
+          if (++its_unchanged > kRangeHeaderSize)
+            break;
+        } else {
+          its_unchanged = 0;
+          its_end = j + 1;
+        }
+      }
+      detail::write_u32(frame_, static_cast<uint32_t>(i));
+      detail::write_u32(frame_, static_cast<uint32_t>(its_end - i));
+      frame_.insert(frame_.end(), _value + i, _value + its_end);
+      if (frame_.size() >= kHeaderSize + _length)
+        return false;
+      i = its_end;
+    }
+    return true;
+  }
+
+  void write_header(frame_type_e _type, uint32_t _base, std::size_t _length) {
+    frame_.clear();
+    detail::write_u32(frame_, kMagic);
+    frame_.push_back(static_cast<vsomeip::byte_t>(_type));
+    detail::write_u32(frame_, sequence_);
+    detail::write_u32(frame_, _base);
+    detail::write_u32(frame_, static_cast<uint32_t>(_length));
+  }
+
+  const uint32_t keyframe_interval_;
+  uint32_t sequence_;
+  uint32_t since_keyframe_;
+  bool has_base_;
+  std::vector<vsomeip::byte_t> base_;
+  std::vector<vsomeip::byte_t> frame_;
+  uint64_t keyframes_;
+  uint64_t deltas_;
+  uint64_t encoded_bytes_;
+  uint64_t full_bytes_;
+};
+
+/// decoder::apply()的结果
+enum class apply_result_e : uint8_t {
+  AR_KEYFRAME,
+  AR_DELTA,
+  /// delta的基准不是最后应用的帧，需要重新同步
+  AR_GAP,
+  AR_MALFORMED
+};
+
+/**
+ * @brief Reconstruct the field value from keyframes and deltas
+ * @note 非线程安全
+ */
+class decoder {
+public:
+  decoder() : has_value_(false), sequence_(0) {}
+
+  /**
+   * @brief Apply one frame
+   * @note 返回AR_GAP或AR_MALFORMED后，在下一个keyframe之前value()无效
+   */
+  apply_result_e apply(const vsomeip::byte_t *_data, std::size_t _length) {
+    if (_length < kHeaderSize || detail::read_u32(_data) != kMagic)
+      return fail(apply_result_e::AR_MALFORMED);
+    const uint8_t its_type = _data[4];
+    const uint32_t its_sequence = detail::read_u32(_data + 5);
+    const uint32_t its_base = detail::read_u32(_data + 9);
+    const uint32_t its_size = detail::read_u32(_data + 13);
+    const vsomeip::byte_t *its_body = _data + kHeaderSize;
+    const std::size_t its_body_length = _length - kHeaderSize;
+
+    if (its_type == static_cast<uint8_t>(frame_type_e::FT_KEYFRAME)) {
+      if (its_body_length != its_size)
+        return fail(apply_result_e::AR_MALFORMED);
+      value_.assign(its_body, its_body + its_body_length);
+      sequence_ = its_sequence;
+      has_value_ = true;
+      return apply_result_e::AR_KEYFRAME;
+    }
+    if (its_type != static_cast<uint8_t>(frame_type_e::FT_DELTA))
+      return fail(apply_result_e::AR_MALFORMED);
+    if (!has_value_ || its_base != sequence_)
+      return fail(apply_result_e::AR_GAP);
+
+    // 先校验所有范围，避免应用一半的delta
+    std::size_t its_offset = 0;
+    while (its_offset < its_body_length) {
+      if (its_body_length - its_offset < kRangeHeaderSize)
+        return fail(apply_result_e::AR_MALFORMED);
+      const uint32_t its_start = detail::read_u32(its_body + its_offset);
+      const uint32_t its_count = detail::read_u32(its_body + its_offset + 4);
+      its_offset += kRangeHeaderSize;
+      if (its_body_length - its_offset < its_count ||
+          its_start > its_size || its_size - its_start < its_count)
+        return fail(apply_result_e::AR_MALFORMED);
+      its_offset += its_count;
+    }
+    value_.resize(its_size);
+    its_offset = 0;
+    while (its_offset < its_body_length) {
+      const uint32_t its_start = detail::read_u32(its_body + its_offset);
+      const uint32_t its_count = detail::read_u32(its_body + its_offset + 4);
+      its_offset += kRangeHeaderSize;
+      std::copy(its_body + its_offset, its_body + its_offset + its_count,
+                value_.begin() + its_start);
+      its_offset += its_count;
+    }
+    sequence_ = its_sequence;
+    return apply_result_e::AR_DELTA;
+  }
+
+  bool has_value() const { return has_value_; }
+  const std::vector<vsomeip::byte_t> &value() const { return value_; }
+
+private:
+  apply_result_e fail(apply_result_e _result) {
+    has_value_ = false;
+    return _result;
+  }
+
+  bool has_value_;
+  uint32_t sequence_;
+  std::vector<vsomeip::byte_t> value_;
+};
+
+} // namespace delta_codec
+
+#endif // VSOMEIP_EXAMPLES_DELTA_CODEC_HPP
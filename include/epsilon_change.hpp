@@ -0,0 +1,233 @@
+#ifndef VSOMEIP_EXAMPLES_EPSILON_CHANGE_HPP
+#define VSOMEIP_EXAMPLES_EPSILON_CHANGE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VSOMEIP_EXAMPLES_EPSILON_SIMD
+#endif
+
+#include <vsomeip/vsomeip.hpp>
+
+/**
+ * @brief offer_event()的_epsilon_change_func比较器
+ * @note vsomeip在field的payload更新时调用比较器：返回true表示变化足够大，
+ * 需要发送notification；返回false表示抑制本次发送
+ * @note 长度不同的payload总是视为变化
+ */
+namespace epsilon_change {
+
+/**
+ * @brief 比较器的调用统计，可以在多个比较器之间共享
+ */
+struct counters {
+  std::atomic<uint64_t> sent_{0};
+  std::atomic<uint64_t> suppressed_{0};
+};
+
+namespace detail {
+
+#ifdef VSOMEIP_EXAMPLES_EPSILON_SIMD
+inline bool has_avx2() {
+  static const bool its_result = __builtin_cpu_supports("avx2");
+  return its_result;
+}
+
+/// 32字节一组比较((a ^ b) & mask)，返回已比较的字节数；发现差异时返回SIZE_MAX
+__attribute__((target("avx2"))) inline std::size_t
+differs_avx2(const vsomeip::byte_t *_a, const vsomeip::byte_t *_b,
+             const vsomeip::byte_t *_mask, std::size_t _length) {
+  std::size_t i = 0;
+  __m256i its_diff = _mm256_setzero_si256();
+  for (; i + 32 <= _length; i += 32) {
+    __m256i its_xor = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_a + i)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_b + i)));
+    if (_mask)
+      its_xor = _mm256_and_si256(
+          its_xor,
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_mask + i)));
+    its_diff = _mm256_or_si256(its_diff, its_xor);
+  }
+  return _mm256_testz_si256(its_diff, its_diff) ? i : SIZE_MAX;
+}
+
+/// SSE2在x86_64上总是可用，16字节一组比较
+inline std::size_t differs_sse2(const vsomeip::byte_t *_a,
+                                const vsomeip::byte_t *_b,
+                                const vsomeip::byte_t *_mask,
+                                std::size_t _length) {
+  std::size_t i = 0;
+  __m128i its_diff = _mm_setzero_si128();
+  for (; i + 16 <= _length; i += 16) {
+    __m128i its_xor = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(_a + i)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(_b + i)));
+    if (_mask)
+      its_xor = _mm_and_si128(
+          its_xor,
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(_mask + i)));
+    its_diff = _mm_or_si128(its_diff, its_xor);
+  }
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(its_diff, _mm_setzero_si128())) ==
+                 0xFFFF
+             ? i
+             : SIZE_MAX;
+}
+#endif
+
+/**
+ * @brief Whether (_a ^ _b) & _mask has any bit set
+ * @param _mask 为nullptr时比较所有字节
+ */
+inline bool differs(const vsomeip::byte_t *_a, const vsomeip::byte_t *_b,
+                    const vsomeip::byte_t *_mask, std::size_t _length) {
+  std::size_t i = 0;
+#ifdef VSOMEIP_EXAMPLES_EPSILON_SIMD
+  i = has_avx2() ? differs_avx2(_a, _b, _mask, _length)
+                 : differs_sse2(_a, _b, _mask, _length);
+  if (i == SIZE_MAX)
+    return true;
+#endif
+  for (; i < _length; ++i) {
+    if ((_a[i] ^ _b[i]) & (_mask ? _mask[i] : 0xFF))
+      return true;
+  }
+  return false;
+}
+
+/// 按大端(SOME/IP字节序)读取一个元素
+template <typename T> T read_element(const vsomeip::byte_t *_data) {
+  typedef typename std::conditional<
+      sizeof(T) == 8, uint64_t,
+      typename std::conditional<
+          sizeof(T) == 4, uint32_t,
+          typename std::conditional<sizeof(T) == 2, uint16_t,
+                                    uint8_t>::type>::type>::type bits_t;
+  bits_t its_bits = 0;
+  for (std::size_t i = 0; i < sizeof(T); ++i)
+    its_bits = static_cast<bits_t>((its_bits << 8) | _data[i]);
+  T its_value;
+  std::memcpy(&its_value, &its_bits, sizeof(T));
+  return its_value;
+}
+
+} // namespace detail
+
+/**
+ * @brief Wrap a comparator so every decision is counted
+ */
+inline vsomeip::epsilon_change_func_t
+counted(vsomeip::epsilon_change_func_t _func,
+        std::shared_ptr<counters> _counters) {
+  return [_func, _counters](const std::shared_ptr<vsomeip::payload> &_old,
+                            const std::shared_ptr<vsomeip::payload> &_new) {
+    const bool is_changed = _func(_old, _new);
+    (is_changed ? _counters->sent_ : _counters->suppressed_)
+        .fetch_add(1, std::memory_order_relaxed);
+    return is_changed;
+  };
+}
+
+/**
+ * @brief Send only if any byte changed
+ * @note 使用AVX2/SSE2逐块比较
+ */
+inline vsomeip::epsilon_change_func_t exact() {
+  return [](const std::shared_ptr<vsomeip::payload> &_old,
+            const std::shared_ptr<vsomeip::payload> &_new) {
+    if (_old->get_length() != _new->get_length())
+      return true;
+    return detail::differs(_old->get_data(), _new->get_data(), nullptr,
+                           _new->get_length());
+  };
+}
+
+/**
+ * @brief Send only if a byte selected by _mask changed
+ * @param _mask 0xFF表示比较该字节，0x00表示忽略(例如时间戳)；也可以只忽略部分位。
+ * 超出_mask长度的字节全部比较
+ */
+inline vsomeip::epsilon_change_func_t
+masked(std::vector<vsomeip::byte_t> _mask) {
+  return [_mask](const std::shared_ptr<vsomeip::payload> &_old,
+                 const std::shared_ptr<vsomeip::payload> &_new) {
+    const std::size_t its_length = _new->get_length();
+    if (_old->get_length() != its_length)
+      return true;
+    const std::size_t its_masked = std::min(its_length, _mask.size());
+    return detail::differs(_old->get_data(), _new->get_data(), _mask.data(),
+                           its_masked) ||
+           detail::differs(_old->get_data() + its_masked,
+                           _new->get_data() + its_masked, nullptr,
+                           its_length - its_masked);
+  };
+}
+
+/**
+ * @brief Build a mask for masked() that ignores [_offset, _offset + _length)
+ */
+inline std::vector<vsomeip::byte_t> ignore_range(std::size_t _offset,
+                                                 std::size_t _length) {
+  std::vector<vsomeip::byte_t> its_mask(_offset + _length, 0xFF);
+  std::fill(its_mask.begin() + _offset, its_mask.end(), 0x00);
+  return its_mask;
+}
+
+/**
+ * @brief Send only if an element moved by more than _epsilon
+ * @note payload从_offset开始被视为大端的T数组，例如float/int32传感器值
+ * @note _offset之前的字节(例如时间戳)被忽略，末尾不足一个元素的字节逐字节比较
+ *
+ * @tparam T 元素类型，整数或浮点数
+ * @param _epsilon 允许的最大差值(包含)
+ * @param _offset 数组在payload中的起始位置
+ */
+template <typename T>
+vsomeip::epsilon_change_func_t numeric_tolerance(T _epsilon,
+                                                 std::size_t _offset = 0) {
+  static_assert(std::is_arithmetic<T>::value, "T must be arithmetic");
+  return [_epsilon, _offset](const std::shared_ptr<vsomeip::payload> &_old,
+                             const std::shared_ptr<vsomeip::payload> &_new) {
+    const std::size_t its_length = _new->get_length();
+    if (_old->get_length() != its_length)
+      return true;
+    if (its_length <= _offset)
+      return false;
+    const vsomeip::byte_t *its_old = _old->get_data() + _offset;
+    const vsomeip::byte_t *its_new = _new->get_data() + _offset;
+    const std::size_t its_count = (its_length - _offset) / sizeof(T);
+    for (std::size_t i = 0; i < its_count; ++i) {
+      const T its_a = detail::read_element<T>(its_old + i * sizeof(T));
+      const T its_b = detail::read_element<T>(its_new + i * sizeof(T));
+      if constexpr (std::is_integral<T>::value) {
+        // 用无符号数求差，避免有符号整数溢出
+        typedef typename std::make_unsigned<T>::type unsigned_t;
+        const unsigned_t its_delta =
+            its_a > its_b ? unsigned_t(unsigned_t(its_a) - unsigned_t(its_b))
+                          : unsigned_t(unsigned_t(its_b) - unsigned_t(its_a));
+        if (its_delta > static_cast<unsigned_t>(_epsilon))
+          return true;
+      } else {
+        // NaN与任何值比较都为false，视为变化
+        if (!(std::fabs(its_a - its_b) <= _epsilon))
+          return true;
+      }
+    }
+    const std::size_t its_tail = its_count * sizeof(T);
+    return detail::differs(its_old + its_tail, its_new + its_tail, nullptr,
+                           its_length - _offset - its_tail);
+  };
+}
+
+} // namespace epsilon_change
+
+#endif // VSOMEIP_EXAMPLES_EPSILON_CHANGE_HPP
@@ -0,0 +1,63 @@
+#ifndef VSOMEIP_EXAMPLES_EVENT_RANGE_HPP
+#define VSOMEIP_EXAMPLES_EVENT_RANGE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+
+#include <vsomeip/vsomeip.hpp>
+
+/**
+ * @brief 连续生成的event/eventgroup ID范围，publisher和subscriber使用相同的规则
+ * @note 第i个event的ID为_first_event + i，属于第(i % eventgroups)个eventgroup，
+ * 第j个eventgroup的ID为_first_eventgroup + j
+ * @note event ID必须在0x8000-0xFFFF之间，数量超出范围时会被截断
+ */
+class event_range {
+public:
+  event_range(vsomeip::event_t _first_event, uint32_t _events,
+              vsomeip::eventgroup_t _first_eventgroup, uint32_t _eventgroups)
+      : first_event_(_first_event),
+        events_(std::max<uint32_t>(
+            1, std::min<uint32_t>(_events, 0x10000u - _first_event))),
+        first_eventgroup_(_first_eventgroup),
+        eventgroups_(std::max<uint32_t>(
+            1, std::min<uint32_t>({_eventgroups, events_,
+                                   0xFFFFu - _first_eventgroup}))) {}
+
+  uint32_t events() const { return events_; }
+  uint32_t eventgroups() const { return eventgroups_; }
+
+  vsomeip::event_t event(uint32_t _index) const {
+    return static_cast<vsomeip::event_t>(first_event_ + _index);
+  }
+
+  vsomeip::eventgroup_t eventgroup(uint32_t _index) const {
+    return static_cast<vsomeip::eventgroup_t>(first_eventgroup_ + _index);
+  }
+
+  /// 第_index个event所属的eventgroup
+  vsomeip::eventgroup_t eventgroup_of(uint32_t _index) const {
+    return eventgroup(_index % eventgroups_);
+  }
+
+  /// _event在范围内的下标，不在范围内时返回events()
+  uint32_t index_of(vsomeip::event_t _event) const {
+    const uint32_t its_index = static_cast<uint32_t>(_event - first_event_);
+    return (_event >= first_event_ && its_index < events_) ? its_index
+                                                           : events_;
+  }
+
+  /// 用于offer_event/request_event的eventgroup集合
+  std::set<vsomeip::eventgroup_t> groups_of(uint32_t _index) const {
+    return std::set<vsomeip::eventgroup_t>{eventgroup_of(_index)};
+  }
+
+private:
+  vsomeip::event_t first_event_;
+  uint32_t events_;
+  vsomeip::eventgroup_t first_eventgroup_;
+  uint32_t eventgroups_;
+};
+
+#endif // VSOMEIP_EXAMPLES_EVENT_RANGE_HPP
@@ -0,0 +1,138 @@
+#ifndef VSOMEIP_EXAMPLES_LATENCY_HISTOGRAM_HPP
+#define VSOMEIP_EXAMPLES_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+/**
+ * @brief HDR风格的对数-线性直方图，用于记录延时(单位ns)
+ * @note 每个2的幂区间被划分为kSubBuckets/2个线性子桶，
+ * 相对误差不超过1/64(约1.56%)
+ * @note 非线程安全，调用者需要自行加锁
+ */
+class latency_histogram {
+public:
+  latency_histogram()
+      : counts_(kBucketCount, 0), count_(0), sum_(0),
+        min_(std::numeric_limits<uint64_t>::max()), max_(0) {}
+
+  /**
+   * @brief Record one value
+   * @param _value 延时，单位ns
+   */
+  void record(uint64_t _value) {
+    counts_[index_of(_value)]++;
+    count_++;
+    sum_ += _value;
+    min_ = std::min(min_, _value);
+    max_ = std::max(max_, _value);
+  }
+
+  /**
+   * @brief Merge another histogram into this one
+   */
+  void merge(const latency_histogram &_other) {
+    for (std::size_t i = 0; i < kBucketCount; ++i)
+      counts_[i] += _other.counts_[i];
+    count_ += _other.count_;
+    sum_ += _other.sum_;
+    min_ = std::min(min_, _other.min_);
+    max_ = std::max(max_, _other.max_);
+  }
+
+  void reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t min() const { return count_ ? min_ : 0; }
+  uint64_t max() const { return max_; }
+  double mean() const {
+    return count_ ? static_cast<double>(sum_) / count_ : 0.0;
+  }
+
+  /**
+   * @brief Value at the given percentile
+   * @param _percentile 0-100之间的百分位
+   * @return 对应桶的上界(不超过记录到的最大值)
+   */
+  uint64_t percentile(double _percentile) const {
+    if (count_ == 0)
+      return 0;
+    uint64_t its_rank =
+        static_cast<uint64_t>(_percentile / 100.0 * count_ + 0.5);
+    its_rank = std::max<uint64_t>(1, std::min(its_rank, count_));
+    uint64_t its_seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+      its_seen += counts_[i];
+      if (its_seen >= its_rank)
+        return std::min(upper_bound_of(i), max_);
+    }
+    return max_;
+  }
+
+  /**
+   * @brief Print p50/p90/p99/p99.9/max in microseconds
+   */
+  void print(std::ostream &_out) const {
+    auto us = [](uint64_t _ns) { return static_cast<double>(_ns) / 1000.0; };
+    const std::ios_base::fmtflags its_flags = _out.flags();
+    const std::streamsize its_precision = _out.precision();
+    _out << std::dec << std::fixed << std::setprecision(1)
+         << "count=" << count_ << " mean=" << us(mean())
+         << "us p50=" << us(percentile(50.0))
+         << "us p90=" << us(percentile(90.0))
+         << "us p99=" << us(percentile(99.0))
+         << "us p99.9=" << us(percentile(99.9)) << "us max=" << us(max())
+         << "us";
+    _out.flags(its_flags);
+    _out.precision(its_precision);
+  }
+
+private:
+  /// 每个2的幂区间的子桶位数
+  static constexpr unsigned kSubBucketBits = 7;
+  static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+  static constexpr uint64_t kHalfSubBuckets = kSubBuckets / 2;
+  static constexpr std::size_t kBucketCount =
+      kSubBuckets + (64 - kSubBucketBits) * kHalfSubBuckets;
+
+  static unsigned msb_of(uint64_t _value) {
+    return 63u - static_cast<unsigned>(__builtin_clzll(_value));
+  }
+
+  static std::size_t index_of(uint64_t _value) {
+    if (_value < kSubBuckets)
+      return static_cast<std::size_t>(_value);
+    unsigned its_shift = msb_of(_value) - (kSubBucketBits - 1);
+    uint64_t its_sub = _value >> its_shift; // [kHalfSubBuckets, kSubBuckets)
+    return static_cast<std::size_t>(kSubBuckets +
+                                    (its_shift - 1) * kHalfSubBuckets +
+                                    (its_sub - kHalfSubBuckets));
+  }
+
+  static uint64_t upper_bound_of(std::size_t _index) {
+    if (_index < kSubBuckets)
+      return _index;
+    uint64_t its_shift = (_index - kSubBuckets) / kHalfSubBuckets + 1;
+    uint64_t its_sub = (_index - kSubBuckets) % kHalfSubBuckets +
+                       kHalfSubBuckets;
+    return ((its_sub + 1) << its_shift) - 1;
+  }
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t min_;
+  uint64_t max_;
+};
+
+#endif // VSOMEIP_EXAMPLES_LATENCY_HISTOGRAM_HPP
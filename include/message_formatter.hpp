@@ -0,0 +1,270 @@
+#ifndef VSOMEIP_EXAMPLES_MESSAGE_FORMATTER_HPP
+#define VSOMEIP_EXAMPLES_MESSAGE_FORMATTER_HPP
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VSOMEIP_EXAMPLES_HEX_DUMP_SSSE3
+#endif
+
+#include <vsomeip/vsomeip.hpp>
+
+#include "type_map.hpp"
+
+/**
+ * @brief SOME/IP消息头的原始字段
+ * @note 平凡类型，可以直接拷贝到日志缓冲区中，稍后再格式化
+ */
+struct message_header {
+  vsomeip::service_t service_;
+  vsomeip::instance_t instance_;
+  vsomeip::method_t method_;
+  vsomeip::client_t client_;
+  vsomeip::session_t session_;
+  vsomeip::length_t length_;
+  vsomeip::protocol_version_t protocol_version_;
+  vsomeip::interface_version_t interface_version_;
+  vsomeip::message_type_e message_type_;
+  vsomeip::return_code_e return_code_;
+  bool is_reliable_;
+  bool is_valid_crc_;
+
+  static message_header from(const vsomeip::message &_message) {
+    message_header its_header;
+    its_header.service_ = _message.get_service();
+    its_header.instance_ = _message.get_instance();
+    its_header.method_ = _message.get_method();
+    its_header.client_ = _message.get_client();
+    its_header.session_ = _message.get_session();
+    its_header.length_ = _message.get_length();
+    its_header.protocol_version_ = _message.get_protocol_version();
+    its_header.interface_version_ = _message.get_interface_version();
+    its_header.message_type_ = _message.get_message_type();
+    its_header.return_code_ = _message.get_return_code();
+    its_header.is_reliable_ = _message.is_reliable();
+    its_header.is_valid_crc_ = _message.is_valid_crc();
+    return its_header;
+  }
+};
+
+/**
+ * @brief 基于固定缓冲区的格式化器
+ * @note 数字用std::to_chars转换，payload十六进制输出在x86上使用SSSE3一次处理16字节
+ * @note 不分配内存；超出kCapacity的内容被截断，并以"..."结尾
+ */
+class message_formatter {
+public:
+  static constexpr std::size_t kCapacity = 1024;
+
+  message_formatter() : size_(0), truncated_(false) {}
+
+  void clear() {
+    size_ = 0;
+    truncated_ = false;
+  }
+
+  std::string_view view() const { return std::string_view(buffer_, size_); }
+
+  message_formatter &append(std::string_view _text) {
+    std::size_t its_size = _text.size();
+    if (its_size > room()) {
+      its_size = room();
+      truncated_ = true;
+    }
+    std::memcpy(buffer_ + size_, _text.data(), its_size);
+    size_ += its_size;
+    return *this;
+  }
+
+  message_formatter &append(char _c) {
+    if (room() == 0) {
+      truncated_ = true;
+      return *this;
+    }
+    buffer_[size_++] = _c;
+    return *this;
+  }
+
+  message_formatter &append_dec(uint64_t _value) {
+    char its_digits[20];
+    auto its_result =
+        std::to_chars(its_digits, its_digits + sizeof(its_digits), _value);
+    return append(std::string_view(its_digits, its_result.ptr - its_digits));
+  }
+
+  /**
+   * @brief Append a zero padded lower case hex number, e.g. 0421
+   */
+  message_formatter &append_hex(uint32_t _value, int _width = 4) {
+    char its_digits[8];
+    auto its_result =
+        std::to_chars(its_digits, its_digits + sizeof(its_digits), _value, 16);
+    int its_length = static_cast<int>(its_result.ptr - its_digits);
+    for (int i = its_length; i < _width; ++i)
+      append('0');
+    return append(std::string_view(its_digits, its_length));
+  }
+
+  message_formatter &append_bool(bool _value) {
+    return append(_value ? '1' : '0');
+  }
+
+  /**
+   * @brief Append "xx xx xx " for every byte, at most _max_bytes bytes
+   */
+  message_formatter &append_hex_dump(const vsomeip::byte_t *_data,
+                                     std::size_t _length,
+                                     std::size_t _max_bytes = kCapacity) {
+    const std::size_t its_written =
+        write_hex(_data, _length < _max_bytes ? _length : _max_bytes);
+    if (its_written < _length)
+      append("...");
+    return *this;
+  }
+
+  /**
+   * @brief Append all header fields in the format used by the samples
+   * @param _what 行首的描述，例如"Received a response from"
+   */
+  message_formatter &append_header(std::string_view _what,
+                                   const message_header &_header) {
+    append(_what).append(" service: ").append_hex(_header.service_);
+    append(", instance: ").append_hex(_header.instance_);
+    append(", client: ").append_hex(_header.client_);
+    append(", method: ").append_hex(_header.method_);
+    append(", session: ").append_hex(_header.session_);
+    append(", length: ").append_dec(_header.length_);
+    append(", protocol version: ").append_dec(_header.protocol_version_);
+    append(", interface version: ").append_dec(_header.interface_version_);
+    append(", message type: ").append(to_string(_header.message_type_));
+    append(", return code: ").append(to_string(_header.return_code_));
+    append(", is reliable: ").append_bool(_header.is_reliable_);
+    append(", is valid crc: ").append_bool(_header.is_valid_crc_);
+    return *this;
+  }
+
+  /**
+   * @brief Append "Service [ssss.iiii] is (NOT) available."
+   * @note 各示例的availability handler共用的输出格式
+   */
+  message_formatter &append_availability(vsomeip::service_t _service,
+                                         vsomeip::instance_t _instance,
+                                         bool _is_available) {
+    append("Service [").append_hex(_service).append('.').append_hex(_instance);
+    append("] is ").append(_is_available ? "available." : "NOT available.");
+    return *this;
+  }
+
+  /**
+   * @brief Append ", payload (N) xx xx ..."
+   * @param _available _data中实际可用的字节数，小于_length时以"..."结尾
+   * @param _length payload的总长度
+   */
+  message_formatter &append_payload(const vsomeip::byte_t *_data,
+                                    std::size_t _available,
+                                    std::size_t _length) {
+    append(", payload (").append_dec(_length).append(") ");
+    if (write_hex(_data, _available) < _length)
+      append("...");
+    return *this;
+  }
+
+  bool is_truncated() const { return truncated_; }
+
+private:
+  static constexpr const char *kHexDigits = "0123456789abcdef";
+
+  std::size_t room() const { return kCapacity - size_; }
+
+  /**
+   * @brief Write as many "xx " groups as fit, keeping room for "..."
+   * @return 实际输出的字节数
+   */
+  std::size_t write_hex(const vsomeip::byte_t *_data, std::size_t _length) {
+    std::size_t its_bytes = _length;
+    const std::size_t its_fit = room() > 3 ? (room() - 3) / 3 : 0;
+    if (its_bytes > its_fit) {
+      its_bytes = its_fit;
+      truncated_ = true;
+    }
+    char *its_out = buffer_ + size_;
+    std::size_t i = 0;
+#ifdef VSOMEIP_EXAMPLES_HEX_DUMP_SSSE3
+    if (has_ssse3()) {
+      for (; i + 16 <= its_bytes; i += 16, its_out += 48)
+        hex_dump_16_ssse3(_data + i, its_out);
+    }
+#endif
+    for (; i < its_bytes; ++i, its_out += 3) {
+      its_out[0] = kHexDigits[_data[i] >> 4];
+      its_out[1] = kHexDigits[_data[i] & 0x0f];
+      its_out[2] = ' ';
+    }
+    size_ = static_cast<std::size_t>(its_out - buffer_);
+    return its_bytes;
+  }
+
+#ifdef VSOMEIP_EXAMPLES_HEX_DUMP_SSSE3
+  static bool has_ssse3() {
+    static const bool its_result = __builtin_cpu_supports("ssse3");
+    return its_result;
+  }
+
+  /**
+   * @brief Convert 16 bytes into 48 characters "xx xx ... xx "
+   * @note 用pshufb查表得到高/低4位对应的字符，再用pshufb插入空格
+   */
+  __attribute__((target("ssse3"))) static void
+  hex_dump_16_ssse3(const vsomeip::byte_t *_in, char *_out) {
+    const __m128i its_digits =
+        _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a',
+                      'b', 'c', 'd', 'e', 'f');
+    const __m128i its_mask = _mm_set1_epi8(0x0f);
+    const __m128i its_bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(_in));
+    const __m128i its_high = _mm_shuffle_epi8(
+        its_digits, _mm_and_si128(_mm_srli_epi16(its_bytes, 4), its_mask));
+    const __m128i its_low =
+        _mm_shuffle_epi8(its_digits, _mm_and_si128(its_bytes, its_mask));
+    // a: 字节0-7的"hl"对，b: 字节8-15的"hl"对
+    const __m128i its_a = _mm_unpacklo_epi8(its_high, its_low);
+    const __m128i its_b = _mm_unpackhi_epi8(its_high, its_low);
+    // 输出中每3个字符为一组"hl "，索引为-1的位置是空格
+    const __m128i its_index0 = _mm_setr_epi8(0, 1, -1, 2, 3, -1, 4, 5, -1, 6,
+                                             7, -1, 8, 9, -1, 10);
+    const __m128i its_index1a = _mm_setr_epi8(11, -1, 12, 13, -1, 14, 15, -1,
+                                              -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i its_index1b = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1,
+                                              0, 1, -1, 2, 3, -1, 4, 5);
+    const __m128i its_index2 = _mm_setr_epi8(-1, 6, 7, -1, 8, 9, -1, 10, 11,
+                                             -1, 12, 13, -1, 14, 15, -1);
+    // pshufb对索引为负的位置写0，再把这些位置替换成空格
+    const __m128i its_spaces = _mm_set1_epi8(' ');
+    const __m128i its_zero = _mm_setzero_si128();
+    auto space_out = [&](__m128i _index) {
+      return _mm_and_si128(_mm_cmplt_epi8(_index, its_zero), its_spaces);
+    };
+    const __m128i its_out0 = _mm_or_si128(_mm_shuffle_epi8(its_a, its_index0),
+                                          space_out(its_index0));
+    const __m128i its_out1 = _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(its_a, its_index1a),
+                     _mm_shuffle_epi8(its_b, its_index1b)),
+        space_out(_mm_and_si128(its_index1a, its_index1b)));
+    const __m128i its_out2 = _mm_or_si128(_mm_shuffle_epi8(its_b, its_index2),
+                                          space_out(its_index2));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_out), its_out0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_out + 16), its_out1);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_out + 32), its_out2);
+  }
+#endif
+
+  char buffer_[kCapacity];
+  std::size_t size_;
+  bool truncated_;
+};
+
+#endif // VSOMEIP_EXAMPLES_MESSAGE_FORMATTER_HPP
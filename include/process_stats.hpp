@@ -0,0 +1,95 @@
+#ifndef VSOMEIP_EXAMPLES_PROCESS_STATS_HPP
+#define VSOMEIP_EXAMPLES_PROCESS_STATS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+/**
+ * @brief 当前进程的CPU时间、内存和线程数，读取自/proc/self
+ * @note 非Linux系统或读取失败时对应字段为0
+ */
+struct process_stats {
+  /// 用户态/内核态CPU时间，单位s
+  double user_cpu_ = 0;
+  double system_cpu_ = 0;
+  /// 常驻内存和峰值常驻内存，单位kB
+  uint64_t rss_kb_ = 0;
+  uint64_t peak_rss_kb_ = 0;
+  uint32_t threads_ = 0;
+  uint64_t voluntary_switches_ = 0;
+  uint64_t involuntary_switches_ = 0;
+  std::chrono::steady_clock::time_point timestamp_;
+
+  static process_stats sample() {
+    process_stats its_stats;
+    its_stats.timestamp_ = std::chrono::steady_clock::now();
+
+    std::ifstream its_stat("/proc/self/stat");
+    std::string its_line;
+    if (std::getline(its_stat, its_line)) {
+      // 第2个字段(comm)可能包含空格，从最后一个')'之后开始解析，
+      // 之后的第1个字段是第3个字段(state)
+      const std::string::size_type its_end = its_line.rfind(')');
+      if (its_end != std::string::npos) {
+        std::istringstream its_fields(its_line.substr(its_end + 1));
+        std::string its_field;
+        uint64_t its_utime = 0, its_stime = 0;
+        for (int i = 3; its_fields >> its_field; ++i) {
+          if (i == 14)
+            its_utime = std::stoull(its_field);
+          else if (i == 15)
+            its_stime = std::stoull(its_field);
+          else if (i == 20) {
+            its_stats.threads_ = static_cast<uint32_t>(std::stoul(its_field));
+            break;
+          }
+        }
+        const double its_ticks = static_cast<double>(sysconf(_SC_CLK_TCK));
+        if (its_ticks > 0) {
+          its_stats.user_cpu_ = its_utime / its_ticks;
+          its_stats.system_cpu_ = its_stime / its_ticks;
+        }
+      }
+    }
+
+    std::ifstream its_status("/proc/self/status");
+    while (std::getline(its_status, its_line)) {
+      std::istringstream its_fields(its_line);
+      std::string its_key;
+      uint64_t its_value = 0;
+      if (!(its_fields >> its_key >> its_value))
+        continue;
+      if (its_key == "VmRSS:")
+        its_stats.rss_kb_ = its_value;
+      else if (its_key == "VmHWM:")
+        its_stats.peak_rss_kb_ = its_value;
+      else if (its_key == "voluntary_ctxt_switches:")
+        its_stats.voluntary_switches_ = its_value;
+      else if (its_key == "nonvoluntary_ctxt_switches:")
+        its_stats.involuntary_switches_ = its_value;
+    }
+    return its_stats;
+  }
+
+  /**
+   * @brief CPU usage between _earlier and this sample, 100 = one full core
+   */
+  double cpu_percent_since(const process_stats &_earlier) const {
+    const double its_wall =
+        std::chrono::duration<double>(timestamp_ - _earlier.timestamp_)
+            .count();
+    if (its_wall <= 0)
+      return 0.0;
+    return 100.0 *
+           ((user_cpu_ + system_cpu_) -
+            (_earlier.user_cpu_ + _earlier.system_cpu_)) /
+           its_wall;
+  }
+};
+
+#endif // VSOMEIP_EXAMPLES_PROCESS_STATS_HPP
@@ -0,0 +1,127 @@
+#ifndef VSOMEIP_EXAMPLES_RATE_PACER_HPP
+#define VSOMEIP_EXAMPLES_RATE_PACER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+
+#include "latency_histogram.hpp"
+
+/**
+ * @brief 按绝对截止时间调度的速率控制器
+ * @note 第k批消息的截止时间为start + k * period，与每批消息的处理耗时无关，
+ * 因此不会像"处理后sleep(cycle)"那样累积漂移
+ * @note 接近截止时间时可以忙等(spin)，以换取微秒级的精度
+ * @note 落后超过kMaxBacklog个周期时放弃追赶，直接跳到下一个截止时间
+ */
+class rate_pacer {
+public:
+  typedef std::chrono::steady_clock clock_t;
+
+  /**
+   * @param _rate 目标速率，单位msgs/s
+   * @param _burst 每个截止时间发送的消息数
+   * @param _spin 截止时间之前忙等的时长，0表示只用sleep
+   */
+  rate_pacer(double _rate, uint32_t _burst, std::chrono::microseconds _spin)
+      : burst_(_burst > 0 ? _burst : 1),
+        period_(std::chrono::nanoseconds(static_cast<int64_t>(
+            1e9 * static_cast<double>(burst_) / (_rate > 0 ? _rate : 1.0)))),
+        spin_(_spin), sent_(0), skipped_(0), window_sent_(0) {
+    if (period_.count() <= 0)
+      period_ = std::chrono::nanoseconds(1);
+    reset();
+  }
+
+  uint32_t burst() const { return burst_; }
+
+  /**
+   * @brief Restart the schedule from now
+   */
+  void reset() {
+    next_ = clock_t::now();
+    window_start_ = next_;
+    window_sent_ = 0;
+    lateness_.reset();
+  }
+
+  /**
+   * @brief Block until the next deadline, then account for one burst
+   */
+  void wait() {
+    const auto its_wake = next_ - spin_;
+    if (clock_t::now() < its_wake)
+      std::this_thread::sleep_until(its_wake);
+    auto its_now = clock_t::now();
+    while (its_now < next_)
+      its_now = clock_t::now();
+
+    lateness_.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(its_now - next_)
+            .count()));
+    next_ += period_;
+    if (its_now - next_ > kMaxBacklog * period_) {
+      const int64_t its_missed = (its_now - next_) / period_;
+      skipped_ += static_cast<uint64_t>(its_missed);
+      next_ += its_missed * period_;
+    }
+  }
+
+  /**
+   * @brief Count messages actually sent since the last report
+   */
+  void sent(uint32_t _count) {
+    sent_ += _count;
+    window_sent_ += _count;
+  }
+
+  /// 距离上次report()是否已经超过_interval
+  bool is_report_due(std::chrono::milliseconds _interval) const {
+    return clock_t::now() - window_start_ >= _interval;
+  }
+
+  /**
+   * @brief Print achieved rate and deadline jitter, then start a new window
+   */
+  void report(std::ostream &_out) {
+    const auto its_now = clock_t::now();
+    const double its_seconds =
+        std::chrono::duration<double>(its_now - window_start_).count();
+    const std::ios_base::fmtflags its_flags = _out.flags();
+    const std::streamsize its_precision = _out.precision();
+    _out << std::dec << std::fixed << std::setprecision(0)
+         << "Paced publishing: target="
+         << static_cast<double>(burst_) * 1e9 /
+                static_cast<double>(period_.count())
+         << " msgs/s, achieved="
+         << (its_seconds > 0 ? window_sent_ / its_seconds : 0.0)
+         << " msgs/s, total=" << sent_ << ", skipped deadlines=" << skipped_
+         << ", deadline lateness ";
+    lateness_.print(_out);
+    _out << std::endl;
+    _out.flags(its_flags);
+    _out.precision(its_precision);
+    window_start_ = its_now;
+    window_sent_ = 0;
+    lateness_.reset();
+  }
+
+private:
+  static constexpr int64_t kMaxBacklog = 100;
+
+  uint32_t burst_;
+  std::chrono::nanoseconds period_;
+  std::chrono::microseconds spin_;
+  clock_t::time_point next_;
+
+  uint64_t sent_;
+  uint64_t skipped_;
+  clock_t::time_point window_start_;
+  uint64_t window_sent_;
+  /// 实际唤醒时间相对截止时间的延迟，即调度抖动
+  latency_histogram lateness_;
+};
+
+#endif // VSOMEIP_EXAMPLES_RATE_PACER_HPP
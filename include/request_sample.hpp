@@ -0,0 +1,586 @@
+// Copyright (C) 2014-2023 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef VSOMEIP_EXAMPLES_REQUEST_SAMPLE_HPP
+#define VSOMEIP_EXAMPLES_REQUEST_SAMPLE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "vsomeip/vsomeip.hpp"
+
+#include "async_client.hpp"
+#include "async_logger.hpp"
+#include "latency_histogram.hpp"
+#include "message_formatter.hpp"
+#include "sample_ids.hpp"
+#include "shm_channel.hpp"
+#include "startup_profile.hpp"
+#include "type_map.hpp"
+
+/**
+ * @brief This class implements a simple VSOMEIP client that sends a request to
+ * a VSOMEIP service.
+ * @note 作为负载生成器：一个线程通过async_client发送请求，响应在回调中统计，
+ * 窗口满时才等待
+ */
+class request_sample {
+public:
+  /**
+   * @brief Constructor
+   * @param use_tcp Flag to indicate whether to use TCP
+   * @param be_quiet Flag to indicate whether to be quiet
+   * @param cycle The cycle time in milliseconds
+   * @param inflight 允许同时在途的请求数，0表示按cycle逐个发送
+   * @param report_interval 延时统计的输出周期，单位ms
+   * @param payload_size 请求payload的字节数
+   * @param duration 服务可用后运行的时长，单位s，到时后自动停止；0表示一直运行
+   * @param csv_path 非空时，停止时把本次运行的结果追加到该CSV文件
+   * @param csv_label 写入CSV第一列的标签，例如进程布局
+   * @param use_shm 响应为shm_descriptor时从共享内存读取，与response的--shm一致
+   * @param startup_csv 非空时，收到第一个响应后把启动各阶段的时间追加到该文件
+   * @param startup_only 收到第一个响应后立即停止，用于测量启动时间
+   * @param timeout 请求的超时时间，单位ms，0表示不检查超时
+   * @param retries 超时后最多重发的次数，用完后按E_TIMEOUT报告给调用者
+   */
+  request_sample(bool use_tcp, bool be_quiet, uint32_t cycle, std::string path,
+                 uint32_t inflight = 0, uint32_t report_interval = 5000,
+                 uint32_t payload_size = 10, uint32_t duration = 0,
+                 std::string csv_path = "", std::string csv_label = "",
+                 bool use_shm = false, std::string startup_csv = "",
+                 bool startup_only = false, uint32_t timeout = 0,
+                 uint32_t retries = 0)
+      : app_(vsomeip::runtime::get()->create_application("request_example")),
+        request_(vsomeip::runtime::get()->create_request(use_tcp)),
+        client_(app_, std::chrono::milliseconds(timeout), retries),
+        use_tcp_(use_tcp), be_quiet_(be_quiet), cycle_(cycle),
+        inflight_(inflight), report_interval_(report_interval),
+        payload_size_(payload_size), duration_(duration),
+        csv_path_(std::move(csv_path)), csv_label_(std::move(csv_label)),
+        use_shm_(use_shm), startup_csv_(std::move(startup_csv)),
+        startup_only_(startup_only), timeout_(timeout), running_(true),
+        is_available_(false), is_measuring_(false), received_(0),
+        received_bytes_(0),
+        last_report_(std::chrono::steady_clock::now()),
+        sender_(std::bind(&request_sample::run, this)) {
+    startup_.mark(startup_profile::SP_CREATED);
+    if (be_quiet_)
+      async_logger::get().set_level(log_level_e::LL_WARNING);
+  }
+
+  /**
+   * @brief Initialize the application
+   * @return true
+   */
+  bool init() {
+    std::cout << "Request example Initing!" << std::endl;
+    /**
+     * @brief Initialize the application
+     *
+     * @note 创建app后，必须首先调用init函数
+     * @note
+     * 如果app_name==""，则会使用环境变量VSOMEIP_APPLICATION_NAME作为app_name
+     * @note 配置文件读取方式：
+     * @note    1. 从环境变量VSOMEIP_CONFIGURATION读取配置文件路径
+     * @note    2. 默认读取当前路径下的vsomeip.json配置文件
+     * @note    3. 从默认路径/etc/vsomeip.json读取配置文件
+     *
+     * @return true if the application is initialized successfully
+     */
+    if (!app_->init()) {
+      std::cerr << "Couldn't initialize application" << std::endl;
+      return false;
+    }
+    startup_.mark(startup_profile::SP_INITIALIZED);
+    std::cout << "Request example Inited!" << std::endl;
+    std::cout << "App name: " << app_->get_name() << std::endl;
+
+    /**
+     * @brief 注册状态处理函数
+     * @note 改函数会在app regester和deregister时被调用
+     * @note 改函数一般在start函数和stop函数之间调用
+     *
+     * @param _handler 状态处理函数，typedef std::function<void(state_type_e)>
+     * state_handler_t;
+     */
+    app_->register_state_handler(
+        std::bind(&request_sample::on_state, this, std::placeholders::_1));
+
+    /**
+     * @brief 注册消息处理函数
+     * @note app必须注册消息处理函数，否则无法处理消息
+     * @note 对于特定的service_id, instance_id,
+     * method_id，只能注册一个handler，如果重复注册，会覆盖之前的handler
+     *
+     * @param _service 服务ID
+     * @param _instance 实例ID
+     * @param _method 方法ID
+     * @param _handler 消息处理函数, typedef std::function<void(const
+     * std::shared_ptr<message>&)> message_handler_t;
+     * @note 响应由client_按request id交给发送时传入的回调
+     */
+    client_.set_unmatched_handler(std::bind(&request_sample::on_unmatched,
+                                            this, std::placeholders::_1));
+    app_->register_message_handler(
+        vsomeip::ANY_SERVICE, RequestResponse_INSTANCE_ID, vsomeip::ANY_METHOD,
+        std::bind(&async_client::on_message, &client_, std::placeholders::_1));
+
+    // 设置请求报文的service_id, instance_id, method_id
+    request_->set_service(RequestResponse_SERVICE_ID);
+    request_->set_instance(RequestResponse_INSTANCE_ID);
+    request_->set_method(RequestResponse_METHOD_ID);
+
+    // 设置消息的payload
+    std::shared_ptr<vsomeip::payload> its_payload =
+        vsomeip::runtime::get()->create_payload();
+    std::vector<vsomeip::byte_t> its_payload_data;
+    for (std::size_t i = 0; i < payload_size_; ++i)
+      its_payload_data.push_back(vsomeip::byte_t(i % 256));
+    its_payload->set_data(its_payload_data);
+    request_->set_payload(its_payload);
+
+    /**
+     * @brief 注册服务可用性处理函数
+     * @note 该函数会在服务apper和disapper时被调用
+     *
+     * @param _service 服务ID
+     * @param _instance 实例ID
+     * @param _handler 服务可用性处理函数，typedef std::function<void(service_t,
+     * instance_t, bool)> availability_handler_t;
+     * @param _major 服务的主版本号，默认为DEFAULT_MAJOR
+     * @param _minor 服务的次版本号，默认为DEFAULT_MINOR
+     */
+    app_->register_availability_handler(
+        RequestResponse_SERVICE_ID, RequestResponse_INSTANCE_ID,
+        std::bind(&request_sample::on_availability, this, std::placeholders::_1,
+                  std::placeholders::_2, std::placeholders::_3));
+    return true;
+  }
+
+  void start() {
+    /**
+     * @brief Start the application
+     * @note
+     * 该函数必须紧跟着init调用。该函数会一直阻塞，直到stop函数被调用或者ctrl+c
+     * @note 该函数会处理收到的消息，并使用对应的registered
+     * handler注册的函数处理消息
+     */
+    app_->start();
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      if (!running_)
+        return;
+      running_ = false;
+    }
+    client_.set_retry_enabled(false);
+    /**
+     * @brief Unregister the state handler
+     * @note 该函数会将之前注册的state handler取消注册
+     */
+    app_->unregister_state_handler();
+    /**
+     * @brief Unregister the message handler
+     * @note 该函数会将之前注册的message handler取消注册
+     *
+     * @param _service 服务ID，也可以设置为ANY_SERVICE
+     * @param _instance 实例ID，也可以设置为ANY_INSTANCE
+     * @param _method 方法ID，也可以设置为ANY_METHOD
+     */
+    app_->unregister_message_handler(RequestResponse_SERVICE_ID,
+                                     RequestResponse_INSTANCE_ID,
+                                     RequestResponse_METHOD_ID);
+    /**
+     * @brief Unregister the availability handler
+     * @note 该函数会将之前注册的availability handler取消注册
+     *
+     * @param _service 服务ID，也可以设置为ANY_SERVICE
+     * @param _instance 实例ID，也可以设置为ANY_INSTANCE
+     * @param _major 服务的主版本号，默认为ANY_MAJOR
+     * @param _minor 服务的次版本号，默认为ANY_MINOR
+     */
+    app_->unregister_availability_handler(RequestResponse_SERVICE_ID,
+                                          RequestResponse_INSTANCE_ID);
+    /**
+     * @brief 清空所有的registered handler
+     */
+    app_->clear_all_handler();
+    /**
+     * @brief 从routing总unregister当前service instance
+     *
+     * @note 当不再需要对应的service
+     * instance时，需要调用该函数。该函数会从routing中unregister当前service
+     * instance
+     * @note 该函数可以避免someip router避免发送不必要的find service消息
+     *
+     * @param _service 服务ID
+     * @param _instance 实例ID
+     */
+    app_->release_service(RequestResponse_SERVICE_ID,
+                          RequestResponse_INSTANCE_ID);
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      std::cout << "Requests sent: " << std::dec << client_.sent()
+                << ", responses matched: " << received_
+                << ", unmatched: " << client_.unmatched()
+                << ", still pending: " << client_.pending();
+      if (timeout_ > 0)
+        std::cout << ", retried: " << client_.retried()
+                  << ", timed out: " << client_.timed_out();
+      if (use_shm_)
+        std::cout << ", shm stale: " << shm_reader_.stale();
+      std::cout << std::endl;
+      print_latency("total", total_latency_);
+      if (!csv_path_.empty())
+        write_csv();
+    }
+    condition_.notify_one();
+    if (std::this_thread::get_id() != sender_.get_id()) {
+      if (sender_.joinable()) {
+        sender_.join();
+      }
+    } else {
+      sender_.detach();
+    }
+    /**
+     * @brief Stop the application
+     * @note 该函数会停止处理消息，因此start函数会再该函数调用后返回
+     */
+    app_->stop();
+  }
+
+  /**
+   * @brief Callback function to handle the state of the VSOMEIP application
+   * @param _state The state of the VSOMEIP application
+   */
+  void on_state(vsomeip::state_type_e _state) {
+    if (_state == vsomeip::state_type_e::ST_REGISTERED) {
+      startup_.mark(startup_profile::SP_REGISTERED);
+      std::cout << "Application " << app_->get_name() << " is registered."
+                << std::endl;
+
+      /**
+       * @brief 将当前app以client的身份注册到VSOMEIP router
+       * @note app需要先调用该函数才能使用对应的service
+       * instance。该函数会告诉VSOMEIP
+       * router此请求，当服务可用时，将app注册到VSOMEIP router
+       *
+       * @param _service 服务ID
+       * @param _instance 实例ID
+       * @param _major 服务的主版本号，默认为ANY_MAJOR
+       * @param _minor 服务的次版本号，默认为ANY_MINOR
+       */
+      app_->request_service(RequestResponse_SERVICE_ID,
+                            RequestResponse_INSTANCE_ID);
+    } else {
+      std::cout << "Application " << app_->get_name() << " is deregistered."
+                << std::endl;
+    }
+  }
+
+  /**
+   * @brief Callback function to handle the availability of a VSOMEIP service
+   * @param _service The service ID
+   * @param _instance The instance ID
+   * @param _is_available Flag to indicate whether the service is available
+   */
+  void on_availability(vsomeip::service_t _service,
+                       vsomeip::instance_t _instance, bool _is_available) {
+    if (_is_available && RequestResponse_SERVICE_ID == _service &&
+        RequestResponse_INSTANCE_ID == _instance)
+      startup_.mark(startup_profile::SP_AVAILABLE);
+    message_formatter its_formatter;
+    its_formatter.append_availability(_service, _instance, _is_available);
+    std::cout << its_formatter.view() << std::endl;
+
+    if (RequestResponse_SERVICE_ID == _service &&
+        RequestResponse_INSTANCE_ID == _instance) {
+      if (is_available_ && !_is_available) {
+        {
+          std::lock_guard<std::mutex> its_lock(mutex_);
+          is_available_ = false;
+        }
+        client_.set_retry_enabled(false);
+        // 服务消失后，在途请求不会再有响应，以E_NOT_REACHABLE结束并清空窗口
+        client_.cancel_all();
+      } else if (_is_available && !is_available_) {
+        std::lock_guard<std::mutex> its_lock(mutex_);
+        if (!is_measuring_) {
+          // 吞吐量和--duration都从服务第一次可用时开始计算
+          is_measuring_ = true;
+          measure_start_ = std::chrono::steady_clock::now();
+        }
+        is_available_ = true;
+        client_.set_retry_enabled(true);
+        condition_.notify_one();
+      }
+    }
+  }
+
+  /**
+   * @brief Drive the requests from one thread
+   * @note 流水线模式下窗口未满时持续发送，直到在途请求数达到inflight_；
+   * 响应在回调中完成，本线程只在窗口满时等待
+   */
+  void run() {
+    std::unique_lock<std::mutex> its_lock(mutex_);
+    while (running_) {
+      if (is_duration_over() ||
+          (startup_only_ && startup_.has(startup_profile::SP_FIRST_RESPONSE))) {
+        its_lock.unlock();
+        stop();
+        return;
+      }
+      report_if_due();
+      // 超时和重试的回调需要获取mutex_
+      its_lock.unlock();
+      client_.poll();
+      its_lock.lock();
+      if (inflight_ > 0) {
+        while (running_ && is_available_ && client_.pending() < inflight_) {
+          its_lock.unlock();
+          send_request();
+          its_lock.lock();
+        }
+        auto its_wakeup = std::min(
+            last_report_ + std::chrono::milliseconds(report_interval_),
+            client_.next_expiry());
+        if (duration_ > 0 && is_measuring_)
+          its_wakeup = std::min(
+              its_wakeup, measure_start_ + std::chrono::seconds(duration_));
+        condition_.wait_until(its_lock, its_wakeup, [this] {
+          return !running_ ||
+                 (is_available_ && client_.pending() < inflight_);
+        });
+        continue;
+      }
+      if (is_available_) {
+        its_lock.unlock();
+        send_request();
+        its_lock.lock();
+      }
+      condition_.wait_for(its_lock, std::chrono::milliseconds(cycle_),
+                          [this] { return !running_; });
+    }
+  }
+
+private:
+  /**
+   * @brief Send request_ through client_
+   * @note 回调可能在本函数返回前运行并获取mutex_，调用者不能持有mutex_
+   */
+  void send_request() {
+    const auto its_sent = std::chrono::steady_clock::now();
+    client_.send_async(
+        request_, [this, its_sent](
+                      const std::shared_ptr<vsomeip::message> &_response) {
+          on_response(_response, its_sent);
+        });
+    async_logger::get().log_message(log_level_e::LL_INFO, "Sent a request to",
+                                    request_);
+  }
+
+  /**
+   * @brief Completion of a request first sent at _sent
+   * @note 重试的请求从第一次发送开始计算延时
+   * @param _response 服务端的响应，或者client_合成的错误
+   */
+  void on_response(const std::shared_ptr<vsomeip::message> &_response,
+                   std::chrono::steady_clock::time_point _sent) {
+    if (async_client::is_local_error(_response)) {
+      // 超时或服务消失，计数由client_维护；唤醒发送线程重新填满窗口
+      async_logger::get().log_message(
+          _response->get_return_code() == vsomeip::return_code_e::E_TIMEOUT
+              ? log_level_e::LL_WARNING
+              : log_level_e::LL_INFO,
+          "Request failed", _response);
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      condition_.notify_one();
+      return;
+    }
+    const auto its_now = std::chrono::steady_clock::now();
+    std::shared_ptr<vsomeip::payload> its_payload = _response->get_payload();
+    std::size_t its_length = its_payload->get_length();
+    // 接管response为本请求保留的槽位引用，函数返回时释放
+    shm_lease its_lease;
+    shm_descriptor its_descriptor;
+    if (use_shm_ && shm_descriptor::decode(its_payload->get_data(), its_length,
+                                           its_descriptor)) {
+      its_lease = shm_reader_.pin(its_descriptor, true);
+      if (its_lease)
+        its_length = its_lease.size();
+    }
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      const uint64_t its_latency =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(its_now - _sent)
+              .count();
+      interval_latency_.record(its_latency);
+      total_latency_.record(its_latency);
+      received_++;
+      received_bytes_ += its_length;
+      if (startup_.mark(startup_profile::SP_FIRST_RESPONSE))
+        report_startup();
+      condition_.notify_one();
+    }
+    async_logger::get().log_message(log_level_e::LL_INFO,
+                                    "Received a response from", _response);
+  }
+
+  /**
+   * @brief Release the slot of a response that arrived after its call ended
+   * @note 超时或重发后迟到的响应仍然携带response为它保留的槽位引用，
+   * 接管后立即释放，不必等response的lease超时
+   */
+  void on_unmatched(const std::shared_ptr<vsomeip::message> &_response) {
+    std::shared_ptr<vsomeip::payload> its_payload = _response->get_payload();
+    shm_descriptor its_descriptor;
+    if (use_shm_ && shm_descriptor::decode(its_payload->get_data(),
+                                           its_payload->get_length(),
+                                           its_descriptor))
+      shm_reader_.pin(its_descriptor, true).release();
+    async_logger::get().log_message(log_level_e::LL_WARNING,
+                                    "Received an unmatched response from",
+                                    _response);
+  }
+
+  /**
+   * @brief Print the startup phases and append them to startup_csv_
+   * @note 调用者必须持有mutex_
+   */
+  void report_startup() const {
+    startup_.print(std::cout);
+    std::cout << std::endl;
+    if (!startup_csv_.empty())
+      startup_.append_csv(startup_csv_, csv_label_);
+  }
+
+  /**
+   * @brief Whether --duration has elapsed since the service became available
+   * @note 调用者必须持有mutex_
+   */
+  bool is_duration_over() const {
+    return duration_ > 0 && is_measuring_ &&
+           std::chrono::steady_clock::now() - measure_start_ >=
+               std::chrono::seconds(duration_);
+  }
+
+  /**
+   * @brief Append one result row to csv_path_, with a header for a new file
+   * @note 调用者必须持有mutex_
+   */
+  void write_csv() const {
+    const double its_seconds =
+        is_measuring_ ? std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - measure_start_)
+                            .count()
+                      : 0.0;
+    const bool is_new = !std::ifstream(csv_path_).good();
+    std::ofstream its_csv(csv_path_, std::ios::app);
+    if (!its_csv) {
+      std::cerr << "Couldn't open " << csv_path_ << std::endl;
+      return;
+    }
+    if (is_new) {
+      its_csv << "label,transport,payload_bytes,inflight,duration_s,requests,"
+                 "responses,unmatched,throughput_rps,throughput_mbps,"
+                 "mean_us,p50_us,p90_us,p99_us,p999_us,max_us,retried,"
+                 "timed_out\n";
+    }
+    auto us = [](uint64_t _ns) { return static_cast<double>(_ns) / 1000.0; };
+    const double its_divisor = its_seconds > 0 ? its_seconds : 1.0;
+    its_csv << std::fixed << std::setprecision(3) << csv_label_ << ","
+            << (use_tcp_ ? "tcp" : "udp") << "," << payload_size_ << ","
+            << inflight_ << "," << its_seconds << "," << client_.sent() << ","
+            << received_ << "," << client_.unmatched() << ","
+            << received_ / its_divisor << ","
+            << (received_ * payload_size_ + received_bytes_) / its_divisor / 1e6
+            << "," << total_latency_.mean() / 1000.0 << ","
+            << us(total_latency_.percentile(50.0)) << ","
+            << us(total_latency_.percentile(90.0)) << ","
+            << us(total_latency_.percentile(99.0)) << ","
+            << us(total_latency_.percentile(99.9)) << ","
+            << us(total_latency_.max()) << "," << client_.retried() << ","
+            << client_.timed_out() << "\n";
+  }
+
+  /**
+   * @brief Print the interval histogram once report_interval_ has elapsed
+   * @note 调用者必须持有mutex_
+   */
+  void report_if_due() {
+    const auto its_now = std::chrono::steady_clock::now();
+    if (its_now - last_report_ < std::chrono::milliseconds(report_interval_))
+      return;
+    print_latency("interval", interval_latency_);
+    interval_latency_.reset();
+    last_report_ = its_now;
+  }
+
+  void print_latency(const char *_label,
+                     const latency_histogram &_histogram) const {
+    std::cout << "Round-trip latency (" << _label << "): ";
+    _histogram.print(std::cout);
+    std::cout << std::endl;
+  }
+
+  /// 必须在app_之前构造，从create_application之前开始计时
+  startup_profile startup_;
+  /// the VSOMEIP application
+  std::shared_ptr<vsomeip::application> app_;
+  /// the request message
+  std::shared_ptr<vsomeip::message> request_;
+  /// 发送request_并按request id交付响应、处理超时和重试
+  async_client client_;
+  /// the flag to indicate whether to use TCP
+  bool use_tcp_;
+  bool be_quiet_;
+  uint32_t cycle_;
+  /// 在途请求窗口大小，0表示按cycle逐个发送
+  uint32_t inflight_;
+  /// 延时统计的输出周期，单位ms
+  uint32_t report_interval_;
+  uint32_t payload_size_;
+  /// 运行时长，单位s，0表示一直运行
+  uint32_t duration_;
+  std::string csv_path_;
+  std::string csv_label_;
+  bool use_shm_;
+  std::string startup_csv_;
+  bool startup_only_;
+  /// 请求的超时时间，单位ms，0表示不检查超时
+  uint32_t timeout_;
+  shm_reader shm_reader_;
+  /// 用于控制线程的运行
+  std::mutex mutex_;
+  /// 用于控制线程的运行
+  std::condition_variable condition_;
+  /// 当前程序是否运行
+  bool running_;
+  /// 服务是否可用
+  bool is_available_;
+  /// 服务第一次可用的时间，受mutex_保护
+  bool is_measuring_;
+  std::chrono::steady_clock::time_point measure_start_;
+  /// 收到响应的请求数，受mutex_保护
+  uint64_t received_;
+  /// 收到的响应payload总字节数
+  uint64_t received_bytes_;
+  /// 往返延时统计，受mutex_保护
+  latency_histogram interval_latency_;
+  latency_histogram total_latency_;
+  std::chrono::steady_clock::time_point last_report_;
+
+  /// 循环发送请求的线程
+  std::thread sender_;
+};
+
+#endif // VSOMEIP_EXAMPLES_REQUEST_SAMPLE_HPP
@@ -0,0 +1,338 @@
+// Copyright (C) 2014-2023 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef VSOMEIP_EXAMPLES_RESPONSE_EXAMPLE_HPP
+#define VSOMEIP_EXAMPLES_RESPONSE_EXAMPLE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include <vsomeip/vsomeip.hpp>
+
+#include "alloc_counter.hpp"
+#include "async_logger.hpp"
+#include "sample_ids.hpp"
+#include "shm_channel.hpp"
+#include "worker_pool.hpp"
+
+/**
+ * @brief This class represents a response example.
+ * @note 分配次数只在链接了src/alloc_counter.cpp的可执行文件中统计
+ */
+class response_example {
+public:
+  /**
+   * @brief Construct the response example.
+   * @param _use_static_routing Use static routing or not.
+   * @param path Configuration path.
+   * @param _workers 处理请求的工作线程数，0表示在vsomeip的dispatcher线程中处理
+   * @param _queue_depth 工作线程池的队列长度，队列满时拒绝请求
+   * @param _payload_size 响应payload的字节数
+   * @param _use_shm 响应数据写入共享内存，响应只携带shm_descriptor；
+   * 仅适用于同一主机上的客户端，客户端需要使用--shm
+   * @param _shm_slots 共享内存的槽位数，应不小于所有客户端的在途请求数之和
+   * @param _shm_lease_ms 客户端在该时间(单位ms)内没有接管响应的槽位时，
+   * 槽位用尽时回收它，应大于客户端的请求超时时间
+   */
+  response_example(bool _use_static_routing, std::string path = "",
+                   uint32_t _workers = 0, uint32_t _queue_depth = 1024,
+                   uint32_t _payload_size = 120, bool _use_shm = false,
+                   uint32_t _shm_slots = 64, uint32_t _shm_lease_ms = 1000)
+      : app_(vsomeip::runtime::get()->create_application("response_example")),
+        is_registered_(false), use_static_routing_(_use_static_routing),
+        payload_size_(_payload_size), use_shm_(_use_shm),
+        shm_slots_(_shm_slots), shm_lease_ms_(_shm_lease_ms), blocked_(false),
+        running_(true), requests_(0), handler_allocs_(0), send_allocs_(0),
+        reported_requests_(0),
+        pool_(_workers > 0
+                  ? new worker_pool<std::shared_ptr<vsomeip::message>>(
+                        _workers, _queue_depth,
+                        std::bind(&response_example::handle_request, this,
+                                  std::placeholders::_1))
+                  : nullptr),
+        offer_thread_(std::bind(&response_example::run, this)) {}
+
+  /**
+   *  @brief Initialize the response example.
+   */
+  bool init() {
+    std::lock_guard<std::mutex> its_lock(mutex_);
+
+    if (!app_->init()) {
+      std::cerr << "Couldn't initialize application" << std::endl;
+      return false;
+    }
+    app_->register_state_handler(
+        std::bind(&response_example::on_state, this, std::placeholders::_1));
+    app_->register_message_handler(
+        RequestResponse_SERVICE_ID, RequestResponse_INSTANCE_ID,
+        RequestResponse_METHOD_ID,
+        std::bind(&response_example::on_message, this, std::placeholders::_1));
+
+    // 响应的payload内容固定，预先生成一次，所有响应共享同一个只读payload
+    std::vector<vsomeip::byte_t> its_payload_data(payload_size_);
+    for (std::size_t i = 0; i < its_payload_data.size(); ++i)
+      its_payload_data[i] = vsomeip::byte_t(i % 256);
+    response_payload_ = vsomeip::runtime::get()->create_payload();
+    response_payload_->set_data(std::move(its_payload_data));
+
+    if (use_shm_ && !shm_.open(static_cast<uint32_t>(getpid()), shm_slots_,
+                               payload_size_))
+      return false;
+    shm_.set_lease_timeout(std::chrono::milliseconds(shm_lease_ms_));
+    return true;
+  }
+
+  /**
+   * @brief Start the response example.
+   */
+  void start() { app_->start(); }
+
+  /**
+   * @brief Stop the response example.
+   */
+  void stop() {
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      running_ = false;
+      blocked_ = true;
+    }
+    app_->clear_all_handler();
+    stop_offer();
+    condition_.notify_one();
+    if (std::this_thread::get_id() != offer_thread_.get_id()) {
+      if (offer_thread_.joinable()) {
+        offer_thread_.join();
+      }
+    } else {
+      offer_thread_.detach();
+    }
+    if (pool_) {
+      pool_->stop();
+    }
+    print_statistics();
+    app_->stop();
+  }
+
+  /**
+   * @brief Offer the service.
+   */
+  void offer() {
+    /**
+     * @brief 提供一个service instance
+     * @note app必须调用该函数，从而将特定的service instance注册到vsomeip
+     * routing中，从而客户端可以找到该service instance
+     * @note
+     * 可以通过配置，从而决定是本地还是跨机器提供服务。如果是跨机器通信，则需要给当前服务示例提供port，否则其他机器无法找到该服务实例
+     *
+     * @param _service 服务ID
+     * @param _instance 实例ID
+     * @param _major 服务的主版本号，默认为DEFAULT_MAJOR
+     * @param _minor 服务的次版本号，默认为DEFAULT_MINOR
+     */
+    app_->offer_service(RequestResponse_SERVICE_ID,
+                        RequestResponse_INSTANCE_ID);
+  }
+
+  /**
+   * @brief Stop offering the service.
+   */
+  void stop_offer() {
+    /**
+     * @brief 停止提供service instance
+     *
+     * @note 调用该函数撤回当前service
+     * instance的注册，从而其他客户端无法找到该service instance
+     *
+     * @param _service 服务ID
+     * @param _instance 实例ID
+     * @param _major 服务的主版本号，默认为DEFAULT_MAJOR
+     * @param _minor 服务的次版本号，默认为DEFAULT_MINOR
+     */
+    app_->stop_offer_service(RequestResponse_SERVICE_ID,
+                             RequestResponse_INSTANCE_ID);
+  }
+
+  /**
+   * @brief Callback function for the state of the application.
+   * @param _state State of the application.
+   */
+  void on_state(vsomeip::state_type_e _state) {
+    std::cout << "Application " << app_->get_name() << " is "
+              << (_state == vsomeip::state_type_e::ST_REGISTERED
+                      ? "registered."
+                      : "deregistered.")
+              << std::endl;
+
+    if (_state == vsomeip::state_type_e::ST_REGISTERED) {
+      if (!is_registered_) {
+        is_registered_ = true;
+        blocked_ = true;
+        condition_.notify_one();
+      }
+    } else {
+      is_registered_ = false;
+    }
+  }
+
+  /**
+   * @brief Callback function for the message.
+   * @param _request Request message.
+   */
+  void on_message(const std::shared_ptr<vsomeip::message> &_request) {
+    async_logger::get().log_message(log_level_e::LL_INFO,
+                                    "Received a request from", _request);
+
+    if (!pool_) {
+      handle_request(_request);
+    } else if (!pool_->try_submit(_request)) {
+      // 队列已满，直接在dispatcher线程中回复E_NOT_READY，避免客户端一直等待
+      std::shared_ptr<vsomeip::message> its_error =
+          vsomeip::runtime::get()->create_response(_request);
+      its_error->set_message_type(vsomeip::message_type_e::MT_ERROR);
+      its_error->set_return_code(vsomeip::return_code_e::E_NOT_READY);
+      app_->send(its_error);
+    }
+  }
+
+  /**
+   * @brief Build and send the response to a request.
+   * @note 未启用工作线程池时运行在dispatcher线程中，否则运行在工作线程中
+   * @note 每个线程复用同一个response对象，预热后本函数不再分配堆内存。
+   * app_->send在返回前已经完成序列化，因此返回后可以安全地复用该对象
+   * @param _request Request message.
+   */
+  void handle_request(const std::shared_ptr<vsomeip::message> &_request) {
+    static thread_local std::shared_ptr<vsomeip::message> its_response;
+    static thread_local std::shared_ptr<vsomeip::payload> its_descriptor;
+
+    const uint64_t its_start = alloc_counter::thread_allocations();
+    if (!its_response) {
+      its_response = vsomeip::runtime::get()->create_response(_request);
+      its_response->set_payload(response_payload_);
+    } else {
+      its_response->set_service(_request->get_service());
+      its_response->set_instance(_request->get_instance());
+      its_response->set_method(_request->get_method());
+      its_response->set_client(_request->get_client());
+      its_response->set_session(_request->get_session());
+      its_response->set_interface_version(_request->get_interface_version());
+      its_response->set_reliable(_request->is_reliable());
+    }
+    if (use_shm_)
+      set_shm_payload(its_response, its_descriptor);
+    const uint64_t its_built = alloc_counter::thread_allocations();
+
+    app_->send(its_response);
+
+    handler_allocs_ += its_built - its_start;
+    send_allocs_ += alloc_counter::thread_allocations() - its_built;
+    requests_++;
+  }
+
+  /**
+   * @brief Write the response data to shared memory and send the descriptor
+   * @note 为客户端预先保留槽位的一个引用，客户端处理完响应后释放。
+   * 客户端没有使用--shm、响应丢失或客户端退出时，该引用在lease超时后由
+   * shm_writer回收。没有空闲槽位时发送数据本身
+   */
+  void set_shm_payload(const std::shared_ptr<vsomeip::message> &_response,
+                       std::shared_ptr<vsomeip::payload> &_descriptor) {
+    shm_descriptor its_slot;
+    if (!shm_.write(response_payload_->get_data(),
+                    response_payload_->get_length(), its_slot, 1)) {
+      _response->set_payload(response_payload_);
+      return;
+    }
+    if (!_descriptor)
+      _descriptor = vsomeip::runtime::get()->create_payload();
+    vsomeip::byte_t its_data[shm_descriptor::kSize];
+    its_slot.encode(its_data);
+    _descriptor->set_data(its_data, sizeof(its_data));
+    _response->set_payload(_descriptor);
+  }
+
+  /**
+   * @brief Run the response example.
+   */
+  void run() {
+    std::unique_lock<std::mutex> its_lock(mutex_);
+    while (!blocked_)
+      condition_.wait(its_lock);
+    offer();
+
+    // 有请求时周期性输出统计信息
+    while (running_) {
+      condition_.wait_for(its_lock, std::chrono::seconds(5));
+      if (running_ && requests_ != reported_requests_)
+        print_statistics();
+    }
+  }
+
+  /**
+   * @brief Print the response path and worker pool counters.
+   */
+  void print_statistics() {
+    const uint64_t its_requests = requests_;
+    reported_requests_ = its_requests;
+    const double its_divisor = its_requests ? double(its_requests) : 1.0;
+    std::cout << "Response path: requests=" << std::dec << its_requests;
+    if (alloc_counter::is_installed())
+      std::cout << ", allocations/request handler="
+                << double(handler_allocs_) / its_divisor
+                << ", allocations/request incl. send="
+                << double(handler_allocs_ + send_allocs_) / its_divisor;
+    std::cout << std::endl;
+    if (pool_) {
+      std::cout << "Worker pool: workers=" << pool_->workers()
+                << ", queued=" << pool_->queued() << "/"
+                << pool_->queue_depth()
+                << ", max queued=" << pool_->max_queued()
+                << ", processed=" << pool_->processed()
+                << ", rejected=" << pool_->rejected() << std::endl;
+    }
+    if (use_shm_) {
+      std::cout << "Shared memory: written=" << shm_.written()
+                << ", no free slot=" << shm_.exhausted()
+                << ", expired leases=" << shm_.reclaimed() << std::endl;
+    }
+  }
+
+private:
+  std::shared_ptr<vsomeip::application> app_;
+  bool is_registered_;
+  bool use_static_routing_;
+  uint32_t payload_size_;
+  bool use_shm_;
+  uint32_t shm_slots_;
+  uint32_t shm_lease_ms_;
+  shm_writer shm_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool blocked_;
+  bool running_;
+
+  /// 所有响应共享的只读payload
+  std::shared_ptr<vsomeip::payload> response_payload_;
+  /// 已处理的请求数，以及处理过程中的堆内存分配次数
+  std::atomic<uint64_t> requests_;
+  std::atomic<uint64_t> handler_allocs_;
+  std::atomic<uint64_t> send_allocs_;
+  uint64_t reported_requests_;
+
+  /// 处理请求的工作线程池，为空时在dispatcher线程中处理
+  std::unique_ptr<worker_pool<std::shared_ptr<vsomeip::message>>> pool_;
+
+  // blocked_ must be initialized before the thread is started.
+  std::thread offer_thread_;
+};
+
+#endif // VSOMEIP_EXAMPLES_RESPONSE_EXAMPLE_HPP
@@ -0,0 +1,223 @@
+// Copyright (C) 2014-2023 Bayerische Motoren Werke Aktiengesellschaft (BMW AG)
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef VSOMEIP_EXAMPLES_ROUTING_SAMPLE_HPP
+#define VSOMEIP_EXAMPLES_ROUTING_SAMPLE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "vsomeip/vsomeip.hpp"
+
+#include "process_stats.hpp"
+#include "sample_ids.hpp"
+#include "stats_socket.hpp"
+#include "type_map.hpp"
+
+/**
+ * @brief This class implements a simple VSOMEIP client that sends a request to
+ * a VSOMEIP service.
+ * @note 可以按周期输出routing host的统计信息：进程CPU/RSS、offer的服务、
+ * 服务可用性的变化。输出到stdout、文件或本地Unix socket
+ */
+class routing_sample {
+public:
+  /**
+   * @param _stats_interval 统计输出周期，单位ms，0表示不输出
+   * @param _stats_file 非空时把快照写入该文件(先写临时文件再rename)
+   * @param _stats_socket 非空时在该路径的Unix socket上提供快照
+   */
+  routing_sample(uint32_t _stats_interval = 0,
+                 const std::string &_stats_file = "",
+                 const std::string &_stats_socket = "")
+      : app_(vsomeip::runtime::get()->create_application("routing_example")),
+        stats_interval_(_stats_interval), stats_file_(_stats_file),
+        stats_socket_path_(_stats_socket), running_(true),
+        availability_changes_(0), start_(std::chrono::steady_clock::now()),
+        last_process_(process_stats::sample()) {}
+
+  bool init() {
+    std::cout << "Routing example Initing!" << std::endl;
+    if (!app_->init()) {
+      std::cerr << "Couldn't initialize application" << std::endl;
+      return false;
+    }
+    std::cout << "Routing example Inited!" << std::endl;
+    std::cout << "App name: " << app_->get_name() << std::endl;
+
+    if (stats_interval_ > 0) {
+      app_->register_availability_handler(
+          vsomeip::ANY_SERVICE, vsomeip::ANY_INSTANCE,
+          std::bind(&routing_sample::on_availability, this,
+                    std::placeholders::_1, std::placeholders::_2,
+                    std::placeholders::_3));
+      if (!stats_socket_path_.empty() &&
+          !stats_socket_.start(stats_socket_path_))
+        return false;
+      stats_thread_ = std::thread(&routing_sample::run_statistics, this);
+    }
+    return true;
+  }
+
+  void start() { app_->start(); }
+
+  /**
+   * @brief Stop the statistics thread and the application
+   * @note 可以重复调用，只有第一次生效。start()返回后必须调用，
+   * 否则统计线程在析构时仍可join
+   */
+  void stop() {
+    {
+      std::lock_guard<std::mutex> its_lock(stats_mutex_);
+      if (!running_)
+        return;
+      running_ = false;
+    }
+    stats_condition_.notify_one();
+    if (stats_thread_.joinable() &&
+        std::this_thread::get_id() != stats_thread_.get_id())
+      stats_thread_.join();
+    stats_socket_.stop();
+    app_->clear_all_handler();
+    app_->stop();
+  }
+
+private:
+  typedef std::pair<vsomeip::service_t, vsomeip::instance_t> service_key_t;
+
+  void on_availability(vsomeip::service_t _service,
+                       vsomeip::instance_t _instance, bool _is_available) {
+    std::lock_guard<std::mutex> its_lock(stats_mutex_);
+    available_[service_key_t(_service, _instance)] = _is_available;
+    availability_changes_++;
+  }
+
+  /**
+   * @brief Ask the routing manager for the offered services of _type
+   * @note 结果异步返回，快照中使用的是上一次返回的列表
+   */
+  void request_offered_services(vsomeip::offer_type_e _type,
+                                std::vector<service_key_t> &_target) {
+    app_->get_offered_services_async(
+        _type, [this, &_target](const std::vector<service_key_t> &_services) {
+          std::lock_guard<std::mutex> its_lock(stats_mutex_);
+          _target = _services;
+        });
+  }
+
+  void run_statistics() {
+    std::unique_lock<std::mutex> its_lock(stats_mutex_);
+    while (running_) {
+      stats_condition_.wait_for(its_lock,
+                                std::chrono::milliseconds(stats_interval_),
+                                [this] { return !running_; });
+      if (!running_)
+        break;
+
+      its_lock.unlock();
+      request_offered_services(vsomeip::offer_type_e::OT_LOCAL,
+                               offered_local_);
+      request_offered_services(vsomeip::offer_type_e::OT_REMOTE,
+                               offered_remote_);
+      const process_stats its_process = process_stats::sample();
+      its_lock.lock();
+
+      const std::string its_snapshot = format_snapshot(its_process);
+      last_process_ = its_process;
+
+      its_lock.unlock();
+      write_snapshot(its_snapshot);
+      its_lock.lock();
+    }
+  }
+
+  /// 调用者必须持有stats_mutex_
+  std::string format_snapshot(const process_stats &_process) const {
+    std::ostringstream its_out;
+    its_out << std::fixed << std::setprecision(2);
+    its_out << "=== " << app_->get_name() << " statistics, uptime "
+            << std::chrono::duration<double>(_process.timestamp_ - start_)
+                   .count()
+            << " s ===\n";
+    its_out << "process: cpu user=" << _process.user_cpu_
+            << "s system=" << _process.system_cpu_
+            << "s usage=" << _process.cpu_percent_since(last_process_)
+            << "% rss=" << _process.rss_kb_
+            << " kB peak rss=" << _process.peak_rss_kb_
+            << " kB threads=" << _process.threads_
+            << " context switches voluntary=" << _process.voluntary_switches_
+            << " involuntary=" << _process.involuntary_switches_ << "\n";
+
+    auto print_services = [&its_out](const char *_label,
+                                     const std::vector<service_key_t> &_list) {
+      its_out << _label << " services offered: " << _list.size() << "\n";
+      for (const service_key_t &its_service : _list) {
+        its_out << "  [" << std::hex << std::setfill('0') << std::setw(4)
+                << its_service.first << "." << std::setw(4)
+                << its_service.second << "]" << std::dec << std::setfill(' ')
+                << "\n";
+      }
+    };
+    print_services("local", offered_local_);
+    print_services("remote", offered_remote_);
+
+    std::size_t its_available = 0;
+    for (const auto &its_entry : available_)
+      if (its_entry.second)
+        its_available++;
+    its_out << "availability: available=" << its_available
+            << " known=" << available_.size()
+            << " changes=" << availability_changes_ << "\n";
+    return its_out.str();
+  }
+
+  void write_snapshot(const std::string &_snapshot) {
+    if (!stats_socket_path_.empty())
+      stats_socket_.publish(_snapshot);
+    if (!stats_file_.empty()) {
+      // 读者不会看到写了一半的文件
+      const std::string its_temporary = stats_file_ + ".tmp";
+      {
+        std::ofstream its_file(its_temporary, std::ios::trunc);
+        its_file << _snapshot;
+      }
+      std::rename(its_temporary.c_str(), stats_file_.c_str());
+    }
+    if (stats_socket_path_.empty() && stats_file_.empty())
+      std::cout << _snapshot << std::flush;
+  }
+
+  /// the VSOMEIP application
+  std::shared_ptr<vsomeip::application> app_;
+
+  uint32_t stats_interval_;
+  std::string stats_file_;
+  std::string stats_socket_path_;
+  stats_socket stats_socket_;
+
+  /// 以下成员只在持有stats_mutex_时访问
+  std::mutex stats_mutex_;
+  std::condition_variable stats_condition_;
+  bool running_;
+  std::map<service_key_t, bool> available_;
+  uint64_t availability_changes_;
+  std::vector<service_key_t> offered_local_;
+  std::vector<service_key_t> offered_remote_;
+  const std::chrono::steady_clock::time_point start_;
+  process_stats last_process_;
+
+  std::thread stats_thread_;
+};
+
+#endif // VSOMEIP_EXAMPLES_ROUTING_SAMPLE_HPP
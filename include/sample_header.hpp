@@ -0,0 +1,65 @@
+#ifndef VSOMEIP_EXAMPLES_SAMPLE_HEADER_HPP
+#define VSOMEIP_EXAMPLES_SAMPLE_HEADER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <vsomeip/vsomeip.hpp>
+
+#include "someip_serializer.hpp"
+
+/**
+ * @brief publisher可选地放在payload开头的头部，用于统计丢包、乱序和单向延时
+ * @note 格式为8字节序号 + 8字节发送时间(ns)，均为大端(网络字节序)
+ * @note 发送时间取自steady_clock(Linux上为CLOCK_MONOTONIC)，只有publisher和
+ * subscriber在同一台主机上时单向延时才有意义
+ */
+struct sample_header {
+  static constexpr std::size_t kSize = 16;
+
+  /// 每个event独立编号，从1开始
+  uint64_t sequence_;
+  /// 发送时间，单位ns
+  uint64_t timestamp_;
+
+  static uint64_t now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  /**
+   * @brief Write the header to the first kSize bytes of _data
+   */
+  void encode(vsomeip::byte_t *_data) const;
+
+  /**
+   * @brief Read the header from the start of a payload
+   * @return false if the payload is shorter than kSize
+   */
+  static bool decode(const vsomeip::byte_t *_data, std::size_t _length,
+                     sample_header &_header);
+};
+
+template <> struct someip_serializer::layout<sample_header> {
+  static constexpr auto members = std::make_tuple(&sample_header::sequence_,
+                                                  &sample_header::timestamp_);
+};
+
+static_assert(someip_serializer::fixed_size<sample_header>() ==
+                  sample_header::kSize,
+              "sample_header layout does not match kSize");
+
+inline void sample_header::encode(vsomeip::byte_t *_data) const {
+  someip_serializer::serialize(*this, _data, kSize);
+}
+
+inline bool sample_header::decode(const vsomeip::byte_t *_data,
+                                  std::size_t _length,
+                                  sample_header &_header) {
+  return someip_serializer::deserialize(_data, _length, _header);
+}
+
+#endif // VSOMEIP_EXAMPLES_SAMPLE_HEADER_HPP
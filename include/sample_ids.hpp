@@ -26,5 +26,6 @@
 #define FieldClient_EVENT_ID 0x9999
 #define FieldClient_SET_METHOD_ID 0x0001
 #define FieldClient_GET_METHOD_ID 0x0002
+#define FieldClient_RESYNC_METHOD_ID 0x0003
 
 #endif // VSOMEIP_EXAMPLES_SAMPLE_IDS_HPP
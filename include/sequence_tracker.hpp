@@ -0,0 +1,139 @@
+#ifndef VSOMEIP_EXAMPLES_SEQUENCE_TRACKER_HPP
+#define VSOMEIP_EXAMPLES_SEQUENCE_TRACKER_HPP
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+#include "latency_histogram.hpp"
+#include "sample_header.hpp"
+
+/**
+ * @brief 序号统计的结果，可以跨多个event合并
+ */
+struct sequence_stats {
+  uint64_t received_ = 0;
+  uint64_t bytes_ = 0;
+  /// 当前仍然缺失的序号数(后来乱序到达的不计入)
+  uint64_t lost_ = 0;
+  uint64_t duplicates_ = 0;
+  /// 比已收到的最大序号小、但之前没有收到过的样本
+  uint64_t reordered_ = 0;
+  /// 比最大序号落后超过窗口大小，无法判断是否重复的样本
+  uint64_t too_late_ = 0;
+  /// 单向延时(接收时间 - 发送时间)，单位ns
+  latency_histogram latency_;
+  /// RFC 3550风格的到达间隔抖动，单位ns
+  double jitter_ = 0;
+
+  void merge(const sequence_stats &_other) {
+    received_ += _other.received_;
+    bytes_ += _other.bytes_;
+    lost_ += _other.lost_;
+    duplicates_ += _other.duplicates_;
+    reordered_ += _other.reordered_;
+    too_late_ += _other.too_late_;
+    latency_.merge(_other.latency_);
+    // 抖动无法相加，取各event中的最大值
+    jitter_ = std::max(jitter_, _other.jitter_);
+  }
+
+  /**
+   * @brief Print the counters, jitter and the one-way latency histogram
+   */
+  void print(std::ostream &_out) const {
+    const std::ios_base::fmtflags its_flags = _out.flags();
+    const std::streamsize its_precision = _out.precision();
+    _out << std::dec << "received=" << received_ << " lost=" << lost_
+         << " duplicates=" << duplicates_ << " reordered=" << reordered_
+         << " too late=" << too_late_ << " jitter=" << std::fixed
+         << std::setprecision(1) << jitter_ / 1000.0
+         << "us, one-way latency ";
+    latency_.print(_out);
+    _out.flags(its_flags);
+    _out.precision(its_precision);
+  }
+};
+
+/**
+ * @brief 根据sample_header的序号统计一个event的丢失、重复和乱序
+ * @note 记录最大序号之前kWindow个序号的接收情况，用于区分重复和乱序
+ * @note 第一个样本之前的序号不计为丢失(subscriber可能晚于publisher启动)
+ * @note 非线程安全，调用者需要自行加锁
+ */
+class sequence_tracker {
+public:
+  static constexpr uint64_t kWindow = 1024;
+
+  sequence_tracker() : highest_(0), last_transit_(0), has_transit_(false) {}
+
+  /**
+   * @brief Account for one received sample
+   * @param _header 解码后的头部
+   * @param _received 接收时间，与sample_header::now()同一时钟
+   * @param _length payload长度(包括头部)
+   */
+  void on_sample(const sample_header &_header, uint64_t _received,
+                 std::size_t _length) {
+    stats_.received_++;
+    stats_.bytes_ += _length;
+
+    const uint64_t its_sequence = _header.sequence_;
+    if (highest_ == 0) {
+      highest_ = its_sequence;
+      seen_.set(0);
+    } else if (its_sequence > highest_) {
+      const uint64_t its_delta = its_sequence - highest_;
+      stats_.lost_ += its_delta - 1;
+      if (its_delta >= kWindow)
+        seen_.reset();
+      else
+        seen_ <<= its_delta;
+      seen_.set(0);
+      highest_ = its_sequence;
+    } else {
+      const uint64_t its_age = highest_ - its_sequence;
+      if (its_age >= kWindow) {
+        stats_.too_late_++;
+      } else if (seen_.test(its_age)) {
+        stats_.duplicates_++;
+        return;
+      } else {
+        seen_.set(its_age);
+        stats_.reordered_++;
+        if (stats_.lost_ > 0)
+          stats_.lost_--;
+      }
+    }
+
+    const int64_t its_transit = static_cast<int64_t>(_received) -
+                                static_cast<int64_t>(_header.timestamp_);
+    if (its_transit >= 0)
+      stats_.latency_.record(static_cast<uint64_t>(its_transit));
+    if (has_transit_) {
+      const int64_t its_d = its_transit - last_transit_;
+      stats_.jitter_ +=
+          (static_cast<double>(its_d < 0 ? -its_d : its_d) - stats_.jitter_) /
+          16.0;
+    }
+    last_transit_ = its_transit;
+    has_transit_ = true;
+  }
+
+  const sequence_stats &stats() const { return stats_; }
+
+  /// 清空延时直方图，用于按周期输出
+  void reset_latency() { stats_.latency_.reset(); }
+
+private:
+  uint64_t highest_;
+  /// 第k位表示序号highest_ - k是否已收到
+  std::bitset<kWindow> seen_;
+  int64_t last_transit_;
+  bool has_transit_;
+  sequence_stats stats_;
+};
+
+#endif // VSOMEIP_EXAMPLES_SEQUENCE_TRACKER_HPP
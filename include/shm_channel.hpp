@@ -0,0 +1,536 @@
+#ifndef VSOMEIP_EXAMPLES_SHM_CHANNEL_HPP
+#define VSOMEIP_EXAMPLES_SHM_CHANNEL_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vsomeip/vsomeip.hpp>
+
+#include "someip_serializer.hpp"
+
+/**
+ * @brief 同一主机上大payload的共享内存旁路
+ * @note 发送方把数据写入POSIX共享内存中的一个槽位，SOME/IP消息只携带
+ * shm_descriptor(段、槽位、长度、代数)；接收方按描述符直接在共享内存中读取，
+ * 数据不再经过payload和routing的本地socket。写入槽位本身仍是一次拷贝，
+ * 例如response对每个请求都把响应数据复制进一个槽位
+ * @note 每个槽位有一个进程间共享的引用计数：接收方读取期间持有引用，写方只会
+ * 复用引用计数为0的槽位。槽位被复用后，旧描述符的代数不再匹配，接收方视为过期
+ * @note 写方替接收方预先持有的引用(commit(..., n))在lease超时内没有被接管时，
+ * 写方在槽位用尽时回收它，接收方不使用共享内存、响应丢失或接收方退出都不会
+ * 永久占用槽位。接收方已经持有的引用在其进程崩溃时不会被回收，该槽位不会再被
+ * 复用，直到写方重新创建共享内存
+ */
+
+/**
+ * @brief SOME/IP payload中代替数据的描述符
+ * @note 格式为4字节magic + 4字节段ID + 4字节槽位 + 4字节长度 + 8字节代数，
+ * 均为大端。段ID对应共享内存名称，见shm_segment_name()
+ */
+struct shm_descriptor {
+  static constexpr std::size_t kSize = 24;
+  /// "SHM1"
+  static constexpr uint32_t kMagic = 0x53484D31;
+
+  uint32_t segment_;
+  uint32_t slot_;
+  uint32_t length_;
+  uint64_t generation_;
+
+  void encode(vsomeip::byte_t *_data) const;
+
+  /**
+   * @brief Read a descriptor from a payload
+   * @return false if the payload is not exactly a descriptor
+   */
+  static bool decode(const vsomeip::byte_t *_data, std::size_t _length,
+                     shm_descriptor &_descriptor);
+};
+
+/// magic不是成员，单独写在最前面
+template <> struct someip_serializer::layout<shm_descriptor> {
+  static constexpr auto members =
+      std::make_tuple(&shm_descriptor::segment_, &shm_descriptor::slot_,
+                      &shm_descriptor::length_, &shm_descriptor::generation_);
+};
+
+static_assert(someip_serializer::fixed_size<shm_descriptor>() + 4 ==
+                  shm_descriptor::kSize,
+              "shm_descriptor layout does not match kSize");
+
+inline void shm_descriptor::encode(vsomeip::byte_t *_data) const {
+  someip_serializer::serialize(kMagic, _data, 4);
+  someip_serializer::serialize(*this, _data + 4, kSize - 4);
+}
+
+inline bool shm_descriptor::decode(const vsomeip::byte_t *_data,
+                                   std::size_t _length,
+                                   shm_descriptor &_descriptor) {
+  if (_length != kSize)
+    return false;
+  someip_serializer::reader its_reader(_data, _length);
+  uint32_t its_magic = 0;
+  return its_reader.read(its_magic) && its_magic == kMagic &&
+         its_reader.read(_descriptor);
+}
+
+namespace shm_detail {
+
+constexpr uint32_t kSegmentMagic = 0x56534D31; // "VSM1"
+/// 写方正在写入该槽位，接收方不能获取引用
+constexpr uint32_t kWriting = 0x80000000u;
+
+/// 共享内存开头的段头部
+struct alignas(64) segment_header {
+  uint32_t magic_;
+  uint32_t slots_;
+  uint32_t slot_size_;
+};
+
+/// 每个槽位的头部，之后紧跟slot_size_字节的数据
+struct alignas(64) slot_header {
+  std::atomic<uint32_t> references_;
+  uint32_t length_;
+  std::atomic<uint64_t> generation_;
+  /// references_中写方预先持有、还没有被接收方接管的引用数
+  std::atomic<uint32_t> pending_;
+  /// commit的时间(steady_clock，单位ns)，只由写方使用
+  std::atomic<int64_t> committed_;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory atomics must be lock-free");
+
+inline std::size_t slot_stride(uint32_t _slot_size) {
+  return sizeof(slot_header) + (_slot_size + 63) / 64 * 64;
+}
+
+inline std::size_t segment_size(uint32_t _slots, uint32_t _slot_size) {
+  return sizeof(segment_header) + _slots * slot_stride(_slot_size);
+}
+
+inline slot_header *slot_at(void *_base, uint32_t _slot_size, uint32_t _slot) {
+  return reinterpret_cast<slot_header *>(static_cast<char *>(_base) +
+                                         sizeof(segment_header) +
+                                         _slot * slot_stride(_slot_size));
+}
+
+inline vsomeip::byte_t *data_of(slot_header *_slot) {
+  return reinterpret_cast<vsomeip::byte_t *>(_slot + 1);
+}
+
+} // namespace shm_detail
+
+/// 段ID对应的共享内存名称
+inline std::string shm_segment_name(uint32_t _segment) {
+  char its_name[32];
+  std::snprintf(its_name, sizeof(its_name), "/vsomeip_example_shm_%08x",
+                _segment);
+  return its_name;
+}
+
+/**
+ * @brief 创建共享内存段并写入数据的一方
+ * @note acquire()/commit()可以被多个线程同时调用
+ */
+class shm_writer {
+public:
+  shm_writer()
+      : segment_(0), slots_(0), slot_size_(0), base_(nullptr), size_(0),
+        next_slot_(0),
+        // 写方重启后代数不会与旧描述符重复
+        generation_(static_cast<uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count())),
+        lease_timeout_(std::chrono::seconds(1)), written_(0), exhausted_(0),
+        reclaimed_(0) {}
+
+  shm_writer(const shm_writer &) = delete;
+  shm_writer &operator=(const shm_writer &) = delete;
+
+  ~shm_writer() { close(); }
+
+  /**
+   * @brief Create the segment with _slots slots of _slot_size bytes
+   * @param _segment 段ID，同一主机上唯一，例如进程号
+   */
+  bool open(uint32_t _segment, uint32_t _slots, uint32_t _slot_size) {
+    close();
+    const std::string its_name = shm_segment_name(_segment);
+    const int its_fd =
+        shm_open(its_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (its_fd < 0) {
+      std::cerr << "Couldn't create shared memory " << its_name << ": "
+                << std::strerror(errno) << std::endl;
+      return false;
+    }
+    const std::size_t its_size = shm_detail::segment_size(_slots, _slot_size);
+    void *its_base = MAP_FAILED;
+    if (ftruncate(its_fd, static_cast<off_t>(its_size)) == 0)
+      its_base = mmap(nullptr, its_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      its_fd, 0);
+    ::close(its_fd);
+    if (its_base == MAP_FAILED) {
+      std::cerr << "Couldn't map shared memory " << its_name << ": "
+                << std::strerror(errno) << std::endl;
+      shm_unlink(its_name.c_str());
+      return false;
+    }
+
+    // ftruncate后内容为0，即所有槽位空闲、代数为0
+    segment_ = _segment;
+    slots_ = _slots;
+    slot_size_ = _slot_size;
+    base_ = its_base;
+    size_ = its_size;
+    shm_detail::segment_header *its_header =
+        static_cast<shm_detail::segment_header *>(base_);
+    its_header->slots_ = _slots;
+    its_header->slot_size_ = _slot_size;
+    std::atomic_thread_fence(std::memory_order_release);
+    its_header->magic_ = shm_detail::kSegmentMagic;
+    return true;
+  }
+
+  void close() {
+    if (!base_)
+      return;
+    munmap(base_, size_);
+    shm_unlink(shm_segment_name(segment_).c_str());
+    base_ = nullptr;
+  }
+
+  bool is_open() const { return base_ != nullptr; }
+  uint32_t slot_size() const { return slot_size_; }
+
+  /**
+   * @brief Set how long a pre-held reference waits to be adopted
+   * @note 应大于请求的超时时间，否则仍会被接管的引用可能先被回收，
+   * 接收方届时按过期处理
+   */
+  void set_lease_timeout(std::chrono::milliseconds _timeout) {
+    lease_timeout_ = _timeout;
+  }
+
+  /**
+   * @brief Reserve a free slot for _length bytes
+   * @return 写入位置；_length超过槽位大小或没有空闲槽位时返回nullptr
+   */
+  vsomeip::byte_t *acquire(std::size_t _length, shm_descriptor &_descriptor) {
+    if (!base_ || _length > slot_size_)
+      return nullptr;
+    vsomeip::byte_t *its_target = try_acquire(_length, _descriptor);
+    // 没有空闲槽位时回收超时未被接管的引用，再试一次
+    if (!its_target && reclaim_expired() > 0)
+      its_target = try_acquire(_length, _descriptor);
+    if (!its_target)
+      exhausted_.fetch_add(1, std::memory_order_relaxed);
+    return its_target;
+  }
+
+  /**
+   * @brief Make the slot reserved by acquire() readable
+   * @param _references 替接收方预先持有的引用数。请求/响应这样只有一个接收方
+   * 的场景传1，接收方用shm_reader::pin(..., true)接管该引用，槽位在接收方
+   * 释放或lease超时前不会被复用；接收方数量未知的event传0，读取前槽位可能
+   * 已被复用
+   */
+  void commit(const shm_descriptor &_descriptor, uint32_t _references = 0) {
+    shm_detail::slot_header *its_slot =
+        shm_detail::slot_at(base_, slot_size_, _descriptor.slot_);
+    its_slot->length_ = _descriptor.length_;
+    its_slot->generation_.store(_descriptor.generation_,
+                                std::memory_order_relaxed);
+    its_slot->committed_.store(now_ns(), std::memory_order_relaxed);
+    its_slot->pending_.store(_references, std::memory_order_relaxed);
+    its_slot->references_.store(_references, std::memory_order_release);
+    written_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Copy _data into a free slot and commit it
+   * @return false if no slot was available
+   */
+  bool write(const vsomeip::byte_t *_data, std::size_t _length,
+             shm_descriptor &_descriptor, uint32_t _references = 0) {
+    vsomeip::byte_t *its_target = acquire(_length, _descriptor);
+    if (!its_target)
+      return false;
+    std::memcpy(its_target, _data, _length);
+    commit(_descriptor, _references);
+    return true;
+  }
+
+  /// 成功写入的次数
+  uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+  /// 因为没有空闲槽位或数据过大而写入失败的次数
+  uint64_t exhausted() const {
+    return exhausted_.load(std::memory_order_relaxed);
+  }
+  /// lease超时后被写方回收的预持有引用数
+  uint64_t reclaimed() const {
+    return reclaimed_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  vsomeip::byte_t *try_acquire(std::size_t _length,
+                               shm_descriptor &_descriptor) {
+    const uint32_t its_start =
+        next_slot_.fetch_add(1, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < slots_; ++i) {
+      const uint32_t its_index = (its_start + i) % slots_;
+      shm_detail::slot_header *its_slot =
+          shm_detail::slot_at(base_, slot_size_, its_index);
+      uint32_t its_free = 0;
+      if (its_slot->references_.compare_exchange_strong(
+              its_free, shm_detail::kWriting, std::memory_order_acquire)) {
+        _descriptor.segment_ = segment_;
+        _descriptor.slot_ = its_index;
+        _descriptor.length_ = static_cast<uint32_t>(_length);
+        _descriptor.generation_ =
+            generation_.fetch_add(1, std::memory_order_relaxed) + 1;
+        return shm_detail::data_of(its_slot);
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Drop pre-held references that were not adopted within the timeout
+   * @note 与接收方接管竞争同一个pending_，CAS保证每个引用只被一方取走
+   * @return 回收的引用数
+   */
+  uint32_t reclaim_expired() {
+    const int64_t its_deadline =
+        now_ns() -
+        std::chrono::duration_cast<std::chrono::nanoseconds>(lease_timeout_)
+            .count();
+    uint32_t its_reclaimed = 0;
+    for (uint32_t i = 0; i < slots_; ++i) {
+      shm_detail::slot_header *its_slot =
+          shm_detail::slot_at(base_, slot_size_, i);
+      uint32_t its_pending = its_slot->pending_.load(std::memory_order_relaxed);
+      if (its_pending == 0 ||
+          its_slot->committed_.load(std::memory_order_relaxed) > its_deadline)
+        continue;
+      if (its_slot->pending_.compare_exchange_strong(
+              its_pending, 0, std::memory_order_acq_rel)) {
+        its_slot->references_.fetch_sub(its_pending, std::memory_order_release);
+        its_reclaimed += its_pending;
+      }
+    }
+    reclaimed_.fetch_add(its_reclaimed, std::memory_order_relaxed);
+    return its_reclaimed;
+  }
+
+  uint32_t segment_;
+  uint32_t slots_;
+  uint32_t slot_size_;
+  void *base_;
+  std::size_t size_;
+  std::atomic<uint32_t> next_slot_;
+  std::atomic<uint64_t> generation_;
+  std::chrono::milliseconds lease_timeout_;
+  std::atomic<uint64_t> written_;
+  std::atomic<uint64_t> exhausted_;
+  std::atomic<uint64_t> reclaimed_;
+};
+
+/**
+ * @brief 对一个槽位持有的引用，析构时释放
+ */
+class shm_lease {
+public:
+  shm_lease() : slot_(nullptr), length_(0) {}
+
+  shm_lease(shm_detail::slot_header *_slot, uint32_t _length)
+      : slot_(_slot), length_(_length) {}
+
+  shm_lease(shm_lease &&_other) noexcept
+      : slot_(_other.slot_), length_(_other.length_) {
+    _other.slot_ = nullptr;
+  }
+
+  shm_lease &operator=(shm_lease &&_other) noexcept {
+    if (this != &_other) {
+      release();
+      slot_ = _other.slot_;
+      length_ = _other.length_;
+      _other.slot_ = nullptr;
+    }
+    return *this;
+  }
+
+  shm_lease(const shm_lease &) = delete;
+  shm_lease &operator=(const shm_lease &) = delete;
+
+  ~shm_lease() { release(); }
+
+  explicit operator bool() const { return slot_ != nullptr; }
+  const vsomeip::byte_t *data() const { return shm_detail::data_of(slot_); }
+  std::size_t size() const { return length_; }
+
+  void release() {
+    if (slot_) {
+      slot_->references_.fetch_sub(1, std::memory_order_release);
+      slot_ = nullptr;
+    }
+  }
+
+private:
+  shm_detail::slot_header *slot_;
+  uint32_t length_;
+};
+
+/**
+ * @brief 按描述符读取共享内存的一方，第一次遇到某个段时打开并映射它
+ * @note 可以被多个线程同时调用
+ */
+class shm_reader {
+public:
+  shm_reader() : stale_(0) {}
+
+  shm_reader(const shm_reader &) = delete;
+  shm_reader &operator=(const shm_reader &) = delete;
+
+  ~shm_reader() {
+    for (auto &its_segment : segments_)
+      if (its_segment.second.base_)
+        munmap(its_segment.second.base_, its_segment.second.size_);
+  }
+
+  /**
+   * @brief Take a reference on the slot named by _descriptor
+   * @param _adopt 接管写方通过commit(..., 1)预先持有的引用，而不是新增一个
+   * @return 段无法打开、描述符无效或槽位已被复用时返回空的lease
+   */
+  shm_lease pin(const shm_descriptor &_descriptor, bool _adopt = false) {
+    const mapping *its_mapping = find(_descriptor.segment_);
+    if (!its_mapping || _descriptor.slot_ >= its_mapping->slots_ ||
+        _descriptor.length_ > its_mapping->slot_size_) {
+      stale_.fetch_add(1, std::memory_order_relaxed);
+      return shm_lease();
+    }
+    shm_detail::slot_header *its_slot = shm_detail::slot_at(
+        its_mapping->base_, its_mapping->slot_size_, _descriptor.slot_);
+
+    if (!_adopt) {
+      uint32_t its_references =
+          its_slot->references_.load(std::memory_order_relaxed);
+      do {
+        if (its_references & shm_detail::kWriting) {
+          stale_.fetch_add(1, std::memory_order_relaxed);
+          return shm_lease();
+        }
+      } while (!its_slot->references_.compare_exchange_weak(
+          its_references, its_references + 1, std::memory_order_acquire));
+    } else if (!adopt(its_slot, _descriptor)) {
+      stale_.fetch_add(1, std::memory_order_relaxed);
+      return shm_lease();
+    }
+
+    if (its_slot->generation_.load(std::memory_order_relaxed) !=
+        _descriptor.generation_) {
+      stale_.fetch_add(1, std::memory_order_relaxed);
+      // 接管的引用属于槽位当前代数的接收方，把它还回pending_
+      if (_adopt)
+        its_slot->pending_.fetch_add(1, std::memory_order_release);
+      else
+        its_slot->references_.fetch_sub(1, std::memory_order_release);
+      return shm_lease();
+    }
+    return shm_lease(its_slot, _descriptor.length_);
+  }
+
+  /// 无法读取(槽位已被复用或段不存在)的描述符数
+  uint64_t stale() const { return stale_.load(std::memory_order_relaxed); }
+
+private:
+  /**
+   * @brief Take one of the references the writer pre-held for this slot
+   * @return false if the writer already reclaimed them or the slot was reused
+   */
+  static bool adopt(shm_detail::slot_header *_slot,
+                    const shm_descriptor &_descriptor) {
+    if (_slot->generation_.load(std::memory_order_acquire) !=
+        _descriptor.generation_)
+      return false;
+    uint32_t its_pending = _slot->pending_.load(std::memory_order_relaxed);
+    do {
+      if (its_pending == 0)
+        return false;
+    } while (!_slot->pending_.compare_exchange_weak(
+        its_pending, its_pending - 1, std::memory_order_acquire));
+    return true;
+  }
+
+  struct mapping {
+    void *base_;
+    std::size_t size_;
+    uint32_t slots_;
+    uint32_t slot_size_;
+  };
+
+  const mapping *find(uint32_t _segment) {
+    std::lock_guard<std::mutex> its_lock(mutex_);
+    auto its_found = segments_.find(_segment);
+    if (its_found != segments_.end())
+      return &its_found->second;
+
+    mapping its_mapping{nullptr, 0, 0, 0};
+    const int its_fd = shm_open(shm_segment_name(_segment).c_str(), O_RDWR, 0);
+    if (its_fd < 0)
+      return nullptr;
+    struct stat its_stat;
+    if (fstat(its_fd, &its_stat) == 0 &&
+        static_cast<std::size_t>(its_stat.st_size) >=
+            sizeof(shm_detail::segment_header)) {
+      const std::size_t its_size = static_cast<std::size_t>(its_stat.st_size);
+      void *its_base = mmap(nullptr, its_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, its_fd, 0);
+      if (its_base != MAP_FAILED) {
+        const shm_detail::segment_header *its_header =
+            static_cast<const shm_detail::segment_header *>(its_base);
+        if (its_header->magic_ == shm_detail::kSegmentMagic &&
+            shm_detail::segment_size(its_header->slots_,
+                                     its_header->slot_size_) <= its_size) {
+          its_mapping = mapping{its_base, its_size, its_header->slots_,
+                                its_header->slot_size_};
+        } else {
+          munmap(its_base, its_size);
+        }
+      }
+    }
+    ::close(its_fd);
+    // 打开失败时不记录，写方可能还没有完成初始化，下一条消息再重试
+    if (!its_mapping.base_)
+      return nullptr;
+    return &(segments_[_segment] = its_mapping);
+  }
+
+  std::mutex mutex_;
+  std::map<uint32_t, mapping> segments_;
+  std::atomic<uint64_t> stale_;
+};
+
+#endif // VSOMEIP_EXAMPLES_SHM_CHANNEL_HPP
@@ -0,0 +1,500 @@
+#ifndef VSOMEIP_EXAMPLES_SOMEIP_SERIALIZER_HPP
+#define VSOMEIP_EXAMPLES_SOMEIP_SERIALIZER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <vsomeip/vsomeip.hpp>
+
+/**
+ * @brief 把C++结构体映射为SOME/IP线上格式的序列化器，代替手写的逐字节循环
+ * @note 结构体通过特化layout<T>列出按线上顺序排列的成员：
+ * @code
+ * template <> struct someip_serializer::layout<sensor_sample> {
+ *   static constexpr auto members = std::make_tuple(
+ *       &sensor_sample::timestamp_, &sensor_sample::channels_);
+ * };
+ * @endcode
+ * @note 支持的成员类型：整数、浮点、bool、枚举(按底层类型)、std::array、
+ * 有layout的结构体，以及带4字节长度(字节数)前缀的std::vector、std::string、
+ * array_view和std::string_view。数值均为大端，结构体之间没有填充
+ * @note 只包含定长成员的类型，其线上长度fixed_size<T>()在编译期确定
+ */
+namespace someip_serializer {
+
+/// 结构体的成员列表，由使用者特化
+template <typename T> struct layout;
+
+/**
+ * @brief Zero-copy view of a serialized array of E
+ * @note 反序列化时直接引用payload中的字节，访问元素时才转换字节序；
+ * 只在payload存活期间有效
+ */
+template <typename E> class array_view {
+public:
+  static_assert(std::is_arithmetic<E>::value || std::is_enum<E>::value,
+                "array_view only supports arithmetic elements");
+  using value_type = E;
+
+  array_view() : data_(nullptr), size_(0) {}
+  array_view(const vsomeip::byte_t *_data, std::size_t _size)
+      : data_(_data), size_(_size) {}
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  E operator[](std::size_t _index) const;
+  /// 转换为主机字节序并拷贝到_out，_out至少有size()个元素
+  void copy_to(E *_out) const;
+  const vsomeip::byte_t *bytes() const { return data_; }
+
+private:
+  const vsomeip::byte_t *data_;
+  std::size_t size_;
+};
+
+namespace detail {
+
+template <typename T> struct is_std_array : std::false_type {};
+template <typename E, std::size_t N>
+struct is_std_array<std::array<E, N>> : std::true_type {};
+
+template <typename T> struct is_vector : std::false_type {};
+template <typename E, typename A>
+struct is_vector<std::vector<E, A>> : std::true_type {};
+
+template <typename T> struct is_array_view : std::false_type {};
+template <typename E> struct is_array_view<array_view<E>> : std::true_type {};
+
+template <typename T, typename = void> struct has_layout : std::false_type {};
+template <typename T>
+struct has_layout<T, decltype(void(layout<T>::members))> : std::true_type {};
+
+template <typename T> struct member_pointer;
+template <typename C, typename M> struct member_pointer<M C::*> {
+  using type = M;
+};
+
+template <typename T, std::size_t I>
+using member_t = typename member_pointer<std::decay_t<decltype(
+    std::get<I>(layout<T>::members))>>::type;
+
+template <typename T>
+using indices_t = std::make_index_sequence<
+    std::tuple_size<std::decay_t<decltype(layout<T>::members)>>::value>;
+
+template <typename T>
+constexpr bool is_scalar_v = std::is_arithmetic<T>::value ||
+                             std::is_enum<T>::value;
+
+/// 与T同样大小的无符号整数，用于字节序转换
+template <std::size_t N> struct uint_of;
+template <> struct uint_of<1> { using type = uint8_t; };
+template <> struct uint_of<2> { using type = uint16_t; };
+template <> struct uint_of<4> { using type = uint32_t; };
+template <> struct uint_of<8> { using type = uint64_t; };
+
+inline uint8_t to_big_endian(uint8_t _value) { return _value; }
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+inline uint16_t to_big_endian(uint16_t _value) {
+  return __builtin_bswap16(_value);
+}
+inline uint32_t to_big_endian(uint32_t _value) {
+  return __builtin_bswap32(_value);
+}
+inline uint64_t to_big_endian(uint64_t _value) {
+  return __builtin_bswap64(_value);
+}
+#else
+inline uint16_t to_big_endian(uint16_t _value) { return _value; }
+inline uint32_t to_big_endian(uint32_t _value) { return _value; }
+inline uint64_t to_big_endian(uint64_t _value) { return _value; }
+#endif
+
+template <typename T> void store(vsomeip::byte_t *_out, T _value) {
+  using bits_t = typename uint_of<sizeof(T)>::type;
+  bits_t its_bits;
+  std::memcpy(&its_bits, &_value, sizeof(T));
+  its_bits = to_big_endian(its_bits);
+  std::memcpy(_out, &its_bits, sizeof(T));
+}
+
+template <typename T> T load(const vsomeip::byte_t *_in) {
+  if constexpr (std::is_same<T, bool>::value)
+    return *_in != 0;
+  using bits_t = typename uint_of<sizeof(T)>::type;
+  bits_t its_bits;
+  std::memcpy(&its_bits, _in, sizeof(T));
+  its_bits = to_big_endian(its_bits);
+  T its_value;
+  std::memcpy(&its_value, &its_bits, sizeof(T));
+  return its_value;
+}
+
+/**
+ * @brief Convert _count scalars to big-endian
+ * @note 循环体只有固定长度的memcpy和bswap，编译器可以向量化(-O2/-O3)
+ */
+template <typename T>
+void store_array(vsomeip::byte_t *_out, const T *_in, std::size_t _count) {
+  if (sizeof(T) == 1) {
+    std::memcpy(_out, _in, _count);
+    return;
+  }
+  for (std::size_t i = 0; i < _count; ++i)
+    store(_out + i * sizeof(T), _in[i]);
+}
+
+template <typename T>
+void load_array(T *_out, const vsomeip::byte_t *_in, std::size_t _count) {
+  if (sizeof(T) == 1) {
+    std::memcpy(_out, _in, _count);
+    return;
+  }
+  for (std::size_t i = 0; i < _count; ++i)
+    _out[i] = load<T>(_in + i * sizeof(T));
+}
+
+} // namespace detail
+
+template <typename E>
+E array_view<E>::operator[](std::size_t _index) const {
+  return detail::load<E>(data_ + _index * sizeof(E));
+}
+
+template <typename E> void array_view<E>::copy_to(E *_out) const {
+  detail::load_array(_out, data_, size_);
+}
+
+template <typename T> constexpr std::size_t fixed_size();
+
+namespace detail {
+
+template <typename T, std::size_t... I>
+constexpr std::size_t members_fixed_size(std::index_sequence<I...>) {
+  return ((fixed_size<member_t<T, I>>() != 0) && ...)
+             ? (fixed_size<member_t<T, I>>() + ... + 0)
+             : 0;
+}
+
+} // namespace detail
+
+/**
+ * @brief Wire size of T if it only has fixed-size members, otherwise 0
+ */
+template <typename T> constexpr std::size_t fixed_size() {
+  if constexpr (detail::is_scalar_v<T>) {
+    return sizeof(T);
+  } else if constexpr (detail::is_std_array<T>::value) {
+    return fixed_size<typename T::value_type>() * std::tuple_size<T>::value;
+  } else if constexpr (detail::has_layout<T>::value) {
+    return detail::members_fixed_size<T>(detail::indices_t<T>());
+  } else {
+    return 0;
+  }
+}
+
+/// 4字节长度前缀
+constexpr std::size_t kLengthSize = 4;
+
+template <typename T> std::size_t serialized_size(const T &_value);
+
+namespace detail {
+
+template <typename T> std::size_t dynamic_size(const T &_value) {
+  using E = typename T::value_type;
+  if constexpr (fixed_size<E>() != 0) {
+    return kLengthSize + _value.size() * fixed_size<E>();
+  } else {
+    std::size_t its_size = kLengthSize;
+    for (const E &its_element : _value)
+      its_size += serialized_size(its_element);
+    return its_size;
+  }
+}
+
+template <typename T, std::size_t... I>
+std::size_t members_size(const T &_value, std::index_sequence<I...>) {
+  return (serialized_size(_value.*std::get<I>(layout<T>::members)) + ... + 0);
+}
+
+} // namespace detail
+
+/**
+ * @brief Number of bytes serialize() writes for _value
+ */
+template <typename T> std::size_t serialized_size(const T &_value) {
+  if constexpr (fixed_size<T>() != 0) {
+    (void)_value;
+    return fixed_size<T>();
+  } else if constexpr (detail::is_std_array<T>::value) {
+    // 变长元素的数组没有长度前缀
+    std::size_t its_size = 0;
+    for (const auto &its_element : _value)
+      its_size += serialized_size(its_element);
+    return its_size;
+  } else if constexpr (detail::is_vector<T>::value) {
+    return detail::dynamic_size(_value);
+  } else if constexpr (detail::is_array_view<T>::value) {
+    return kLengthSize + _value.size() * fixed_size<typename T::value_type>();
+  } else if constexpr (std::is_same<T, std::string>::value ||
+                       std::is_same<T, std::string_view>::value) {
+    return kLengthSize + _value.size();
+  } else {
+    static_assert(detail::has_layout<T>::value,
+                  "type needs a someip_serializer::layout specialization");
+    return detail::members_size(_value, detail::indices_t<T>());
+  }
+}
+
+namespace detail {
+
+template <typename T>
+vsomeip::byte_t *write(vsomeip::byte_t *_out, const T &_value);
+
+template <typename T>
+vsomeip::byte_t *write_elements(vsomeip::byte_t *_out, const T &_value) {
+  using E = typename T::value_type;
+  if constexpr (is_scalar_v<E>) {
+    store_array(_out, _value.data(), _value.size());
+    return _out + _value.size() * sizeof(E);
+  } else {
+    for (const E &its_element : _value)
+      _out = write(_out, its_element);
+    return _out;
+  }
+}
+
+template <typename T, std::size_t... I>
+vsomeip::byte_t *write_members(vsomeip::byte_t *_out, const T &_value,
+                               std::index_sequence<I...>) {
+  ((_out = write(_out, _value.*std::get<I>(layout<T>::members))), ...);
+  return _out;
+}
+
+template <typename T>
+vsomeip::byte_t *write(vsomeip::byte_t *_out, const T &_value) {
+  if constexpr (is_scalar_v<T>) {
+    store(_out, _value);
+    return _out + sizeof(T);
+  } else if constexpr (is_std_array<T>::value) {
+    return write_elements(_out, _value);
+  } else if constexpr (is_vector<T>::value || is_array_view<T>::value ||
+                       std::is_same<T, std::string>::value ||
+                       std::is_same<T, std::string_view>::value) {
+    const std::size_t its_size = serialized_size(_value) - kLengthSize;
+    store(_out, static_cast<uint32_t>(its_size));
+    _out += kLengthSize;
+    if constexpr (is_array_view<T>::value) {
+      // 已经是线上格式
+      std::memcpy(_out, _value.bytes(), its_size);
+      return _out + its_size;
+    } else if constexpr (is_vector<T>::value) {
+      return write_elements(_out, _value);
+    } else {
+      std::memcpy(_out, _value.data(), its_size);
+      return _out + its_size;
+    }
+  } else {
+    return write_members(_out, _value, indices_t<T>());
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief Bounds-checked reader over a serialized payload
+ * @note 任何一次越界读取后ok()为false，之后的读取都不再修改输出
+ */
+class reader {
+public:
+  reader(const vsomeip::byte_t *_data, std::size_t _length)
+      : data_(_data), length_(_length), offset_(0), ok_(true) {}
+
+  bool ok() const { return ok_; }
+  std::size_t offset() const { return offset_; }
+  std::size_t remaining() const { return length_ - offset_; }
+
+  template <typename T> bool read(T &_value) {
+    if (!ok_)
+      return false;
+    if constexpr (detail::is_scalar_v<T>) {
+      const vsomeip::byte_t *its_data = take(sizeof(T));
+      if (its_data)
+        _value = detail::load<T>(its_data);
+    } else if constexpr (detail::is_std_array<T>::value) {
+      read_elements(_value.data(), _value.size());
+    } else if constexpr (detail::is_vector<T>::value) {
+      read_vector(_value);
+    } else if constexpr (detail::is_array_view<T>::value) {
+      using E = typename T::value_type;
+      std::size_t its_size = 0;
+      const vsomeip::byte_t *its_data = take_sized(its_size);
+      if (its_data && its_size % sizeof(E) != 0)
+        ok_ = false;
+      else if (its_data)
+        _value = T(its_data, its_size / sizeof(E));
+    } else if constexpr (std::is_same<T, std::string>::value ||
+                         std::is_same<T, std::string_view>::value) {
+      std::size_t its_size = 0;
+      const vsomeip::byte_t *its_data = take_sized(its_size);
+      if (its_data)
+        _value = T(reinterpret_cast<const char *>(its_data), its_size);
+    } else {
+      read_members(_value, detail::indices_t<T>());
+    }
+    return ok_;
+  }
+
+private:
+  const vsomeip::byte_t *take(std::size_t _size) {
+    if (!ok_ || length_ - offset_ < _size) {
+      ok_ = false;
+      return nullptr;
+    }
+    const vsomeip::byte_t *its_data = data_ + offset_;
+    offset_ += _size;
+    return its_data;
+  }
+
+  /// 读取长度前缀和之后的_size字节
+  const vsomeip::byte_t *take_sized(std::size_t &_size) {
+    uint32_t its_size = 0;
+    if (!read(its_size))
+      return nullptr;
+    _size = its_size;
+    return take(_size);
+  }
+
+  template <typename E> void read_elements(E *_out, std::size_t _count) {
+    if constexpr (detail::is_scalar_v<E>) {
+      const vsomeip::byte_t *its_data = take(_count * sizeof(E));
+      if (its_data)
+        detail::load_array(_out, its_data, _count);
+    } else {
+      for (std::size_t i = 0; i < _count && ok_; ++i)
+        read(_out[i]);
+    }
+  }
+
+  template <typename T> void read_vector(T &_value) {
+    using E = typename T::value_type;
+    std::size_t its_size = 0;
+    const vsomeip::byte_t *its_data = take_sized(its_size);
+    if (!its_data)
+      return;
+    if constexpr (fixed_size<E>() != 0) {
+      if (its_size % fixed_size<E>() != 0) {
+        ok_ = false;
+        return;
+      }
+      _value.resize(its_size / fixed_size<E>());
+      reader its_elements(its_data, its_size);
+      its_elements.read_elements(_value.data(), _value.size());
+      ok_ = its_elements.ok();
+    } else {
+      // 变长元素只能逐个读取，直到用完长度前缀给出的字节
+      _value.clear();
+      reader its_elements(its_data, its_size);
+      while (its_elements.ok() && its_elements.remaining() > 0) {
+        _value.emplace_back();
+        its_elements.read(_value.back());
+      }
+      ok_ = its_elements.ok();
+    }
+  }
+
+  template <typename T, std::size_t... I>
+  void read_members(T &_value, std::index_sequence<I...>) {
+    (read(_value.*std::get<I>(layout<T>::members)), ...);
+  }
+
+  const vsomeip::byte_t *data_;
+  std::size_t length_;
+  std::size_t offset_;
+  bool ok_;
+};
+
+/**
+ * @brief Serialize _value into _out, which is resized to the exact size
+ */
+template <typename T>
+void serialize(const T &_value, std::vector<vsomeip::byte_t> &_out) {
+  _out.resize(serialized_size(_value));
+  detail::write(_out.data(), _value);
+}
+
+/**
+ * @brief Serialize _value into a caller provided buffer
+ * @return 写入的字节数，_capacity不足时返回0且不写入
+ */
+template <typename T>
+std::size_t serialize(const T &_value, vsomeip::byte_t *_out,
+                      std::size_t _capacity) {
+  const std::size_t its_size = serialized_size(_value);
+  if (its_size > _capacity)
+    return 0;
+  detail::write(_out, _value);
+  return its_size;
+}
+
+/**
+ * @brief Deserialize _value from the start of a payload
+ * @note 与SOME/IP的可扩展性规则一致，忽略末尾多余的字节
+ * @return false if the payload is too short or a length prefix is invalid
+ */
+template <typename T>
+bool deserialize(const vsomeip::byte_t *_data, std::size_t _length,
+                 T &_value) {
+  reader its_reader(_data, _length);
+  return its_reader.read(_value);
+}
+
+namespace detail {
+
+template <typename T, std::size_t I> constexpr std::size_t member_offset() {
+  if constexpr (I == 0)
+    return 0;
+  else
+    return member_offset<T, I - 1>() + fixed_size<member_t<T, I - 1>>();
+}
+
+} // namespace detail
+
+/**
+ * @brief Zero-copy view of a fixed-size struct in a payload
+ * @note 构造时检查一次长度，之后get<I>()按编译期确定的偏移读取第I个成员，
+ * 不反序列化整个结构体
+ */
+template <typename T> class view {
+public:
+  static_assert(fixed_size<T>() != 0, "view requires a fixed-size layout");
+
+  view(const vsomeip::byte_t *_data, std::size_t _length)
+      : data_(_length >= fixed_size<T>() ? _data : nullptr) {}
+
+  bool valid() const { return data_ != nullptr; }
+
+  /// 调用者必须先检查valid()
+  template <std::size_t I> detail::member_t<T, I> get() const {
+    using M = detail::member_t<T, I>;
+    M its_value;
+    reader its_reader(data_ + detail::member_offset<T, I>(), fixed_size<M>());
+    its_reader.read(its_value);
+    return its_value;
+  }
+
+private:
+  const vsomeip::byte_t *data_;
+};
+
+} // namespace someip_serializer
+
+#endif // VSOMEIP_EXAMPLES_SOMEIP_SERIALIZER_HPP
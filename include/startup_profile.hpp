@@ -0,0 +1,136 @@
+#ifndef VSOMEIP_EXAMPLES_STARTUP_PROFILE_HPP
+#define VSOMEIP_EXAMPLES_STARTUP_PROFILE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief 记录一个应用从创建到第一次收到响应的各个阶段的时间
+ * @note 各阶段的时间都相对于对象构造的时刻，对象需要在create_application
+ * 之前构造；每个阶段只记录第一次到达的时间
+ * @note exec_ms为进程启动(exec)到对象构造的时间，包括动态库加载，
+ * 精度受/proc/self/stat的时钟节拍限制(通常10ms)
+ */
+class startup_profile {
+public:
+  enum phase_e : uint8_t {
+    SP_CREATED,        ///< create_application返回
+    SP_INITIALIZED,    ///< init()返回
+    SP_REGISTERED,     ///< on_state(ST_REGISTERED)
+    SP_AVAILABLE,      ///< on_availability(true)
+    SP_FIRST_RESPONSE, ///< 第一个匹配的响应
+    SP_COUNT
+  };
+
+  startup_profile()
+      : start_(std::chrono::steady_clock::now()), exec_ms_(process_age_ms()) {
+    for (std::atomic<int64_t> &its_phase : phases_)
+      its_phase = -1;
+  }
+
+  /**
+   * @brief Record the first time _phase is reached
+   * @note 可以在任意线程中调用
+   * @return true if this call recorded the phase
+   */
+  bool mark(phase_e _phase) {
+    int64_t its_expected = -1;
+    const int64_t its_elapsed = static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_)
+            .count());
+    return phases_[_phase].compare_exchange_strong(its_expected, its_elapsed);
+  }
+
+  bool has(phase_e _phase) const { return phases_[_phase].load() >= 0; }
+
+  /// 到达_phase时距对象构造的时间，单位ms，尚未到达时为-1
+  double elapsed_ms(phase_e _phase) const {
+    const int64_t its_elapsed = phases_[_phase].load();
+    return its_elapsed < 0 ? -1.0 : static_cast<double>(its_elapsed) / 1e6;
+  }
+
+  void print(std::ostream &_out) const {
+    const std::ios_base::fmtflags its_flags = _out.flags();
+    const std::streamsize its_precision = _out.precision();
+    _out << std::fixed << std::setprecision(3)
+         << "Startup (ms since create_application): exec=" << exec_ms_;
+    for (uint8_t i = 0; i < SP_COUNT; ++i)
+      _out << ", " << kNames[i] << "=" << elapsed_ms(phase_e(i));
+    _out.flags(its_flags);
+    _out.precision(its_precision);
+  }
+
+  /**
+   * @brief Append one row to _path, with a header for a new file
+   * @note 未到达的阶段写为空
+   */
+  void append_csv(const std::string &_path, const std::string &_label) const {
+    const bool is_new = !std::ifstream(_path).good();
+    std::ofstream its_csv(_path, std::ios::app);
+    if (!its_csv) {
+      std::cerr << "Couldn't open " << _path << std::endl;
+      return;
+    }
+    if (is_new) {
+      its_csv << "label,exec_ms";
+      for (uint8_t i = 0; i < SP_COUNT; ++i)
+        its_csv << "," << kNames[i] << "_ms";
+      its_csv << "\n";
+    }
+    its_csv << std::fixed << std::setprecision(3) << _label << "," << exec_ms_;
+    for (uint8_t i = 0; i < SP_COUNT; ++i) {
+      its_csv << ",";
+      if (has(phase_e(i)))
+        its_csv << elapsed_ms(phase_e(i));
+    }
+    its_csv << "\n";
+  }
+
+private:
+  /// 本进程启动到现在的时间，单位ms，无法读取时为-1
+  static double process_age_ms() {
+    std::ifstream its_stat("/proc/self/stat");
+    std::string its_line;
+    if (!std::getline(its_stat, its_line))
+      return -1.0;
+    // 第2个字段(comm)可能包含空格，从最后一个')'之后开始数，starttime是第22个
+    const std::string::size_type its_end = its_line.rfind(')');
+    if (its_end == std::string::npos)
+      return -1.0;
+    std::stringstream its_fields(its_line.substr(its_end + 1));
+    std::string its_field;
+    for (int i = 3; i <= 22; ++i)
+      if (!(its_fields >> its_field))
+        return -1.0;
+    std::stringstream converter;
+    converter << its_field;
+    unsigned long long its_ticks = 0;
+    timespec its_now;
+    const long its_hz = sysconf(_SC_CLK_TCK);
+    if (!(converter >> its_ticks) || its_hz <= 0 ||
+        clock_gettime(CLOCK_BOOTTIME, &its_now) != 0)
+      return -1.0;
+    return (static_cast<double>(its_now.tv_sec) * 1e3 +
+            static_cast<double>(its_now.tv_nsec) / 1e6) -
+           static_cast<double>(its_ticks) * 1e3 / static_cast<double>(its_hz);
+  }
+
+  static constexpr const char *kNames[SP_COUNT] = {
+      "create", "init", "registered", "available", "first_response"};
+
+  const std::chrono::steady_clock::time_point start_;
+  const double exec_ms_;
+  std::atomic<int64_t> phases_[SP_COUNT];
+};
+
+#endif // VSOMEIP_EXAMPLES_STARTUP_PROFILE_HPP
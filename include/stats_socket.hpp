@@ -0,0 +1,122 @@
+#ifndef VSOMEIP_EXAMPLES_STATS_SOCKET_HPP
+#define VSOMEIP_EXAMPLES_STATS_SOCKET_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief 在本地Unix socket上提供最新的统计快照
+ * @note 每个连接写入一次当前快照后关闭，例如：socat - UNIX-CONNECT:<path>
+ * @note publish()只替换快照字符串，不会等待客户端
+ */
+class stats_socket {
+public:
+  stats_socket() : fd_(-1), running_(false) {}
+
+  stats_socket(const stats_socket &) = delete;
+  stats_socket &operator=(const stats_socket &) = delete;
+
+  ~stats_socket() { stop(); }
+
+  /**
+   * @brief Bind _path and start serving snapshots
+   * @return false if the socket could not be created
+   */
+  bool start(const std::string &_path) {
+    sockaddr_un its_address;
+    std::memset(&its_address, 0, sizeof(its_address));
+    its_address.sun_family = AF_UNIX;
+    if (_path.size() >= sizeof(its_address.sun_path)) {
+      std::cerr << "Statistics socket path too long: " << _path << std::endl;
+      return false;
+    }
+    std::strncpy(its_address.sun_path, _path.c_str(),
+                 sizeof(its_address.sun_path) - 1);
+
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+      std::cerr << "Couldn't create statistics socket: " << std::strerror(errno)
+                << std::endl;
+      return false;
+    }
+    unlink(_path.c_str());
+    if (bind(fd_, reinterpret_cast<sockaddr *>(&its_address),
+             sizeof(its_address)) < 0 ||
+        listen(fd_, 4) < 0) {
+      std::cerr << "Couldn't bind statistics socket " << _path << ": "
+                << std::strerror(errno) << std::endl;
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    path_ = _path;
+    running_ = true;
+    thread_ = std::thread(&stats_socket::serve, this);
+    return true;
+  }
+
+  void stop() {
+    if (!running_.exchange(false))
+      return;
+    if (thread_.joinable())
+      thread_.join();
+    close(fd_);
+    fd_ = -1;
+    unlink(path_.c_str());
+  }
+
+  /**
+   * @brief Replace the snapshot handed to the next client
+   */
+  void publish(std::string _snapshot) {
+    std::lock_guard<std::mutex> its_lock(snapshot_mutex_);
+    snapshot_.swap(_snapshot);
+  }
+
+private:
+  void serve() {
+    while (running_) {
+      pollfd its_poll = {fd_, POLLIN, 0};
+      if (poll(&its_poll, 1, 200) <= 0)
+        continue;
+      const int its_client = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+      if (its_client < 0)
+        continue;
+      std::string its_snapshot;
+      {
+        std::lock_guard<std::mutex> its_lock(snapshot_mutex_);
+        its_snapshot = snapshot_;
+      }
+      std::size_t its_sent = 0;
+      while (its_sent < its_snapshot.size()) {
+        const ssize_t its_result =
+            send(its_client, its_snapshot.data() + its_sent,
+                 its_snapshot.size() - its_sent, MSG_NOSIGNAL);
+        if (its_result <= 0)
+          break;
+        its_sent += static_cast<std::size_t>(its_result);
+      }
+      close(its_client);
+    }
+  }
+
+  int fd_;
+  std::string path_;
+  std::atomic<bool> running_;
+  std::thread thread_;
+
+  std::mutex snapshot_mutex_;
+  std::string snapshot_;
+};
+
+#endif // VSOMEIP_EXAMPLES_STATS_SOCKET_HPP
@@ -0,0 +1,192 @@
+#ifndef VSOMEIP_EXAMPLES_TIMER_WHEEL_HPP
+#define VSOMEIP_EXAMPLES_TIMER_WHEEL_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 分层时间轮，用于跟踪大量在途请求的截止时间
+ * @note 共kLevels层，每层kSlots个槽：第0层每个槽为1个tick，第l层每个槽为
+ * kSlots^l个tick。定时器先放在能容纳它的最低层，所在的高层槽转到时再下移
+ * 到低层(cascade)，因此插入、取消都是O(1)，每个tick只处理一个槽
+ * @note 取消只删除索引；槽中的记录转到时按generation识别并跳过(惰性删除)，
+ * 不需要为每个定时器分配链表节点
+ * @note 截止时间向上取整到tick，定时器不会提前到期，最多晚一个tick
+ * @note 非线程安全，调用者负责加锁
+ */
+template <typename Key, typename Hash = std::hash<Key>> class timer_wheel {
+public:
+  typedef std::chrono::steady_clock clock_t;
+
+  static constexpr uint32_t kSlotBits = 8;
+  static constexpr uint32_t kSlots = 1u << kSlotBits;
+  static constexpr uint32_t kLevels = 4;
+
+  /**
+   * @param _tick 时间轮的精度
+   */
+  explicit timer_wheel(std::chrono::microseconds _tick)
+      : tick_(_tick.count() > 0 ? _tick : std::chrono::microseconds(1)),
+        origin_(clock_t::now()), now_tick_(0), generation_(0) {}
+
+  std::size_t size() const { return timers_.size(); }
+  bool empty() const { return timers_.empty(); }
+
+  /**
+   * @brief Schedule _key to expire at _deadline
+   * @note _key已存在时替换原来的截止时间；已过去的截止时间在下一个tick到期
+   */
+  void schedule(const Key &_key, clock_t::time_point _deadline) {
+    uint64_t its_tick = to_tick(_deadline, true);
+    if (its_tick <= now_tick_)
+      its_tick = now_tick_ + 1;
+    timer &its_timer = timers_[_key];
+    its_timer.tick_ = its_tick;
+    its_timer.generation_ = ++generation_;
+    place(_key, its_timer);
+  }
+
+  /**
+   * @return false if _key was not scheduled
+   */
+  bool cancel(const Key &_key) { return timers_.erase(_key) > 0; }
+
+  void clear() {
+    timers_.clear();
+    for (auto &its_level : slots_)
+      for (auto &its_slot : its_level)
+        its_slot.clear();
+  }
+
+  /**
+   * @brief Turn the wheel up to _now and call _on_expired(key) for every
+   * expired timer
+   * @note _on_expired中可以调用schedule()和cancel()，例如重新调度重试的请求
+   * @return 到期的定时器个数
+   */
+  template <typename F>
+  std::size_t advance(clock_t::time_point _now, F &&_on_expired) {
+    const uint64_t its_target = to_tick(_now, false);
+    std::size_t its_expired = 0;
+    while (now_tick_ < its_target) {
+      if (timers_.empty()) {
+        // 没有定时器时不必逐个tick转动，槽中只剩已取消的记录
+        clear();
+        now_tick_ = its_target;
+        break;
+      }
+      now_tick_++;
+      for (uint32_t its_level = 1; its_level < kLevels; ++its_level) {
+        if ((now_tick_ & ((uint64_t(1) << (kSlotBits * its_level)) - 1)) != 0)
+          break;
+        cascade(its_level);
+      }
+      // 先换出当前槽，回调中调度的定时器不会落入正在处理的槽
+      scratch_.swap(slot(0, now_tick_));
+      for (const entry &its_entry : scratch_) {
+        auto its_timer = timers_.find(its_entry.key_);
+        if (its_timer == timers_.end() ||
+            its_timer->second.generation_ != its_entry.generation_)
+          continue;
+        timers_.erase(its_timer);
+        its_expired++;
+        _on_expired(its_entry.key_);
+      }
+      scratch_.clear();
+    }
+    return its_expired;
+  }
+
+  /**
+   * @brief Latest time the caller may wait before calling advance() again
+   * @note 可能早于真正的下一个截止时间(已取消的记录、cascade)，但不会晚于它
+   */
+  clock_t::time_point next_expiry() const {
+    if (timers_.empty())
+      return clock_t::time_point::max();
+    // 到下一次第0层回绕之前，只有第0层的槽中可能有到期的定时器
+    const uint64_t its_wrap = (now_tick_ | (kSlots - 1)) + 1;
+    for (uint64_t its_tick = now_tick_ + 1; its_tick < its_wrap; ++its_tick)
+      if (!slot(0, its_tick).empty())
+        return to_time(its_tick);
+    return to_time(its_wrap);
+  }
+
+private:
+  struct timer {
+    uint64_t tick_;
+    uint64_t generation_;
+  };
+
+  struct entry {
+    Key key_;
+    uint64_t generation_;
+  };
+
+  typedef std::vector<entry> slot_t;
+
+  uint64_t to_tick(clock_t::time_point _time, bool _round_up) const {
+    if (_time <= origin_)
+      return 0;
+    const auto its_elapsed =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(_time - origin_);
+    const auto its_tick =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(tick_);
+    return static_cast<uint64_t>(
+        (its_elapsed.count() + (_round_up ? its_tick.count() - 1 : 0)) /
+        its_tick.count());
+  }
+
+  clock_t::time_point to_time(uint64_t _tick) const {
+    return origin_ + tick_ * static_cast<int64_t>(_tick);
+  }
+
+  slot_t &slot(uint32_t _level, uint64_t _tick) {
+    return slots_[_level][(_tick >> (kSlotBits * _level)) & (kSlots - 1)];
+  }
+
+  const slot_t &slot(uint32_t _level, uint64_t _tick) const {
+    return slots_[_level][(_tick >> (kSlotBits * _level)) & (kSlots - 1)];
+  }
+
+  /// 放入能容纳剩余tick数的最低层，超出范围的放在最高层，转到时再重新放置
+  void place(const Key &_key, const timer &_timer) {
+    const uint64_t its_delta = _timer.tick_ - now_tick_;
+    uint32_t its_level = 0;
+    while (its_level + 1 < kLevels &&
+           its_delta >= (uint64_t(1) << (kSlotBits * (its_level + 1))))
+      its_level++;
+    uint64_t its_tick = _timer.tick_;
+    if (its_level + 1 == kLevels &&
+        its_delta >= (uint64_t(1) << (kSlotBits * kLevels)))
+      its_tick = now_tick_ + (uint64_t(1) << (kSlotBits * kLevels)) - 1;
+    slot(its_level, its_tick).push_back({_key, _timer.generation_});
+  }
+
+  /// 把第_level层当前槽中仍然有效的定时器重新放到更低的层
+  void cascade(uint32_t _level) {
+    slot_t its_entries;
+    its_entries.swap(slot(_level, now_tick_));
+    for (const entry &its_entry : its_entries) {
+      auto its_timer = timers_.find(its_entry.key_);
+      if (its_timer != timers_.end() &&
+          its_timer->second.generation_ == its_entry.generation_)
+        place(its_entry.key_, its_timer->second);
+    }
+  }
+
+  const std::chrono::microseconds tick_;
+  const clock_t::time_point origin_;
+  /// 已经处理过的最后一个tick
+  uint64_t now_tick_;
+  uint64_t generation_;
+  std::unordered_map<Key, timer, Hash> timers_;
+  std::array<std::array<slot_t, kSlots>, kLevels> slots_;
+  slot_t scratch_;
+};
+
+#endif // VSOMEIP_EXAMPLES_TIMER_WHEEL_HPP
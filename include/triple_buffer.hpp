@@ -0,0 +1,85 @@
+#ifndef VSOMEIP_EXAMPLES_TRIPLE_BUFFER_HPP
+#define VSOMEIP_EXAMPLES_TRIPLE_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief 无锁三缓冲，用于单生产者、单消费者之间传递"最新的完整样本"
+ * @note 生产者写back缓冲区，publish()时与middle交换；消费者update()时把middle
+ * 交换到front。双方都不会等待对方，消费者总是拿到最新一次publish()的样本
+ * @note 消费者来不及取走的样本会被新样本覆盖，覆盖次数记录在overwritten()中
+ * @note T的拷贝赋值如果不分配内存(例如预留了容量的vector)，则整个过程不分配内存
+ *
+ * @tparam T 样本类型
+ */
+template <typename T> class triple_buffer {
+public:
+  explicit triple_buffer(const T &_initial = T())
+      : buffers_{_initial, _initial, _initial}, back_(0), middle_(1),
+        front_(2), published_(0), overwritten_(0) {}
+
+  triple_buffer(const triple_buffer &) = delete;
+  triple_buffer &operator=(const triple_buffer &) = delete;
+
+  /**
+   * @brief Producer: the buffer to fill before publish()
+   */
+  T &write_buffer() { return buffers_[back_]; }
+
+  /**
+   * @brief Producer: make the write buffer the latest sample
+   */
+  void publish() {
+    const uint8_t its_old =
+        middle_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+    back_ = its_old & kIndexMask;
+    published_.fetch_add(1, std::memory_order_relaxed);
+    if (its_old & kFresh)
+      overwritten_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Consumer: take the latest sample if there is a new one
+   * @return true if read_buffer() changed
+   */
+  bool update() {
+    if (!(middle_.load(std::memory_order_relaxed) & kFresh))
+      return false;
+    const uint8_t its_old = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = its_old & kIndexMask;
+    return true;
+  }
+
+  /**
+   * @brief Consumer: the sample taken by the last successful update()
+   */
+  T &read_buffer() { return buffers_[front_]; }
+  const T &read_buffer() const { return buffers_[front_]; }
+
+  /// 生产者publish()的样本数
+  uint64_t published() const {
+    return published_.load(std::memory_order_relaxed);
+  }
+  /// 消费者取走之前就被覆盖的样本数
+  uint64_t overwritten() const {
+    return overwritten_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kFresh = 0x4;
+
+  T buffers_[3];
+  /// 只由生产者访问
+  uint8_t back_;
+  /// 低两位为缓冲区下标，kFresh表示消费者还没有取走
+  alignas(64) std::atomic<uint8_t> middle_;
+  /// 只由消费者访问
+  alignas(64) uint8_t front_;
+
+  std::atomic<uint64_t> published_;
+  std::atomic<uint64_t> overwritten_;
+};
+
+#endif // VSOMEIP_EXAMPLES_TRIPLE_BUFFER_HPP
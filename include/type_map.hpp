@@ -1,14 +1,36 @@
-#include <string>
-#include <unordered_map>
+#ifndef VSOMEIP_EXAMPLES_TYPE_MAP_HPP
+#define VSOMEIP_EXAMPLES_TYPE_MAP_HPP
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
 
 #include "vsomeip/enumeration_types.hpp"
 
-const std::unordered_map<vsomeip::state_type_e, std::string> state_map = {
+/**
+ * @brief 枚举值到名字的编译期映射表
+ * @note 表是constexpr数组，查找是对十几个元素的线性比较，不需要哈希，也不会分配内存
+ * @note 使用to_string(value)查找，未知的值返回"UNKNOWN"
+ */
+template <typename E, std::size_t N>
+using enum_table = std::pair<E, std::string_view>[N];
+
+template <typename E, std::size_t N>
+constexpr std::string_view enum_to_string(const enum_table<E, N> &_table,
+                                          E _value) {
+  for (std::size_t i = 0; i < N; ++i) {
+    if (_table[i].first == _value)
+      return _table[i].second;
+  }
+  return "UNKNOWN";
+}
+
+constexpr enum_table<vsomeip::state_type_e, 2> state_table = {
     {vsomeip::state_type_e::ST_REGISTERED, "ST_REGISTERED"},
     {vsomeip::state_type_e::ST_DEREGISTERED, "ST_DEREGISTERED"},
 };
 
-const std::unordered_map<vsomeip::message_type_e, std::string> message_map = {
+constexpr enum_table<vsomeip::message_type_e, 11> message_table = {
     {vsomeip::message_type_e::MT_REQUEST, "MT_REQUEST"},
     {vsomeip::message_type_e::MT_REQUEST_NO_RETURN, "MT_REQUEST_NO_RETURN"},
     {vsomeip::message_type_e::MT_NOTIFICATION, "MT_NOTIFICATION"},
@@ -23,58 +45,84 @@ const std::unordered_map<vsomeip::message_type_e, std::string> message_map = {
     {vsomeip::message_type_e::MT_UNKNOWN, "MT_UNKNOWN"},
 };
 
-const std::unordered_map<vsomeip::return_code_e, std::string> return_code_map =
-    {
-        {vsomeip::return_code_e::E_OK, "E_OK"},
-        {vsomeip::return_code_e::E_NOT_OK, "E_NOT_OK"},
-        {vsomeip::return_code_e::E_UNKNOWN_SERVICE, "E_UNKNOWN_SERVICE"},
-        {vsomeip::return_code_e::E_UNKNOWN_METHOD, "E_UNKNOWN_METHOD"},
-        {vsomeip::return_code_e::E_NOT_READY, "E_NOT_READY"},
-        {vsomeip::return_code_e::E_NOT_REACHABLE, "E_NOT_REACHABLE"},
-        {vsomeip::return_code_e::E_TIMEOUT, "E_TIMEOUT"},
-        {vsomeip::return_code_e::E_WRONG_PROTOCOL_VERSION,
-         "E_WRONG_PROTOCOL_VERSION"},
-        {vsomeip::return_code_e::E_WRONG_INTERFACE_VERSION,
-         "E_WRONG_INTERFACE_VERSION"},
-        {vsomeip::return_code_e::E_MALFORMED_MESSAGE, "E_MALFORMED_MESSAGE"},
-        {vsomeip::return_code_e::E_WRONG_MESSAGE_TYPE, "E_WRONG_MESSAGE_TYPE"},
-        {vsomeip::return_code_e::E_UNKNOWN, "E_UNKNOWN"},
+constexpr enum_table<vsomeip::return_code_e, 12> return_code_table = {
+    {vsomeip::return_code_e::E_OK, "E_OK"},
+    {vsomeip::return_code_e::E_NOT_OK, "E_NOT_OK"},
+    {vsomeip::return_code_e::E_UNKNOWN_SERVICE, "E_UNKNOWN_SERVICE"},
+    {vsomeip::return_code_e::E_UNKNOWN_METHOD, "E_UNKNOWN_METHOD"},
+    {vsomeip::return_code_e::E_NOT_READY, "E_NOT_READY"},
+    {vsomeip::return_code_e::E_NOT_REACHABLE, "E_NOT_REACHABLE"},
+    {vsomeip::return_code_e::E_TIMEOUT, "E_TIMEOUT"},
+    {vsomeip::return_code_e::E_WRONG_PROTOCOL_VERSION,
+     "E_WRONG_PROTOCOL_VERSION"},
+    {vsomeip::return_code_e::E_WRONG_INTERFACE_VERSION,
+     "E_WRONG_INTERFACE_VERSION"},
+    {vsomeip::return_code_e::E_MALFORMED_MESSAGE, "E_MALFORMED_MESSAGE"},
+    {vsomeip::return_code_e::E_WRONG_MESSAGE_TYPE, "E_WRONG_MESSAGE_TYPE"},
+    {vsomeip::return_code_e::E_UNKNOWN, "E_UNKNOWN"},
 };
 
-const std::unordered_map<vsomeip::routing_state_e, std::string>
-    running_state_map = {
-        {vsomeip::routing_state_e::RS_RUNNING, "RS_RUNNING"},
-        {vsomeip::routing_state_e::RS_SUSPENDED, "RS_SUSPENDED"},
-        {vsomeip::routing_state_e::RS_RESUMED, "RS_RESUMED"},
-        {vsomeip::routing_state_e::RS_SHUTDOWN, "RS_SHUTDOWN"},
-        {vsomeip::routing_state_e::RS_DIAGNOSIS, "RS_DIAGNOSIS"},
-        {vsomeip::routing_state_e::RS_UNKNOWN, "RS_UNKNOWN"},
+constexpr enum_table<vsomeip::routing_state_e, 6> running_state_table = {
+    {vsomeip::routing_state_e::RS_RUNNING, "RS_RUNNING"},
+    {vsomeip::routing_state_e::RS_SUSPENDED, "RS_SUSPENDED"},
+    {vsomeip::routing_state_e::RS_RESUMED, "RS_RESUMED"},
+    {vsomeip::routing_state_e::RS_SHUTDOWN, "RS_SHUTDOWN"},
+    {vsomeip::routing_state_e::RS_DIAGNOSIS, "RS_DIAGNOSIS"},
+    {vsomeip::routing_state_e::RS_UNKNOWN, "RS_UNKNOWN"},
 };
 
-const std::unordered_map<vsomeip::offer_type_e, std::string> offer_type_map = {
+constexpr enum_table<vsomeip::offer_type_e, 3> offer_type_table = {
     {vsomeip::offer_type_e::OT_LOCAL, "OT_LOCAL"},
     {vsomeip::offer_type_e::OT_REMOTE, "OT_REMOTE"},
     {vsomeip::offer_type_e::OT_ALL, "OT_ALL"},
 };
 
-const std::unordered_map<vsomeip::event_type_e, std::string> event_type_map = {
+constexpr enum_table<vsomeip::event_type_e, 4> event_type_table = {
     {vsomeip::event_type_e::ET_EVENT, "ET_EVENT"},
     {vsomeip::event_type_e::ET_SELECTIVE_EVENT, "ET_SELECTIVE_EVENT"},
     {vsomeip::event_type_e::ET_FIELD, "ET_FIELD"},
     {vsomeip::event_type_e::ET_UNKNOWN, "ET_UNKNOWN"},
 };
 
-const std::unordered_map<vsomeip::security_mode_e, std::string>
-    security_mode_map = {
-        {vsomeip::security_mode_e::SM_OFF, "SM_OFF"},
-        {vsomeip::security_mode_e::SM_ON, "SM_ON"},
-        {vsomeip::security_mode_e::SM_AUDIT, "SM_AUDIT"},
+constexpr enum_table<vsomeip::security_mode_e, 3> security_mode_table = {
+    {vsomeip::security_mode_e::SM_OFF, "SM_OFF"},
+    {vsomeip::security_mode_e::SM_ON, "SM_ON"},
+    {vsomeip::security_mode_e::SM_AUDIT, "SM_AUDIT"},
 };
 
-const std::unordered_map<vsomeip::reliability_type_e, std::string>
-    reliability_type_map = {
-        {vsomeip::reliability_type_e::RT_RELIABLE, "RT_RELIABLE"},
-        {vsomeip::reliability_type_e::RT_UNRELIABLE, "RT_UNRELIABLE"},
-        {vsomeip::reliability_type_e::RT_BOTH, "RT_BOTH"},
-        {vsomeip::reliability_type_e::RT_UNKNOWN, "RT_UNKNOWN"},
-};
\ No newline at end of file
+constexpr enum_table<vsomeip::reliability_type_e, 4> reliability_type_table = {
+    {vsomeip::reliability_type_e::RT_RELIABLE, "RT_RELIABLE"},
+    {vsomeip::reliability_type_e::RT_UNRELIABLE, "RT_UNRELIABLE"},
+    {vsomeip::reliability_type_e::RT_BOTH, "RT_BOTH"},
+    {vsomeip::reliability_type_e::RT_UNKNOWN, "RT_UNKNOWN"},
+};
+
+constexpr std::string_view to_string(vsomeip::state_type_e _value) {
+  return enum_to_string(state_table, _value);
+}
+constexpr std::string_view to_string(vsomeip::message_type_e _value) {
+  return enum_to_string(message_table, _value);
+}
+constexpr std::string_view to_string(vsomeip::return_code_e _value) {
+  return enum_to_string(return_code_table, _value);
+}
+constexpr std::string_view to_string(vsomeip::routing_state_e _value) {
+  return enum_to_string(running_state_table, _value);
+}
+constexpr std::string_view to_string(vsomeip::offer_type_e _value) {
+  return enum_to_string(offer_type_table, _value);
+}
+constexpr std::string_view to_string(vsomeip::event_type_e _value) {
+  return enum_to_string(event_type_table, _value);
+}
+constexpr std::string_view to_string(vsomeip::security_mode_e _value) {
+  return enum_to_string(security_mode_table, _value);
+}
+constexpr std::string_view to_string(vsomeip::reliability_type_e _value) {
+  return enum_to_string(reliability_type_table, _value);
+}
+
+static_assert(to_string(vsomeip::return_code_e::E_TIMEOUT) == "E_TIMEOUT",
+              "return_code_table is incomplete");
+
+#endif // VSOMEIP_EXAMPLES_TYPE_MAP_HPP
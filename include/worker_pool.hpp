@@ -0,0 +1,137 @@
+#ifndef VSOMEIP_EXAMPLES_WORKER_POOL_HPP
+#define VSOMEIP_EXAMPLES_WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 固定线程数、有界队列的工作线程池
+ * @note 队列是预分配的环形缓冲区，入队/出队不会分配内存
+ * @note 队列满时try_submit直接返回false，由调用者决定如何拒绝请求
+ *
+ * @tparam T 队列中的任务数据，所有任务由同一个handler处理
+ */
+template <typename T> class worker_pool {
+public:
+  typedef std::function<void(T &)> handler_t;
+
+  /**
+   * @brief Construct and start the pool
+   * @param _workers 工作线程数
+   * @param _queue_depth 队列最大长度
+   * @param _handler 在工作线程中处理任务的函数
+   */
+  worker_pool(std::size_t _workers, std::size_t _queue_depth,
+              handler_t _handler)
+      : handler_(std::move(_handler)),
+        slots_(_queue_depth > 0 ? _queue_depth : 1), head_(0), size_(0),
+        running_(true), max_size_(0), submitted_(0), rejected_(0),
+        processed_(0) {
+    for (std::size_t i = 0; i < (_workers > 0 ? _workers : 1); ++i)
+      workers_.emplace_back(&worker_pool::run, this);
+  }
+
+  ~worker_pool() { stop(); }
+
+  worker_pool(const worker_pool &) = delete;
+  worker_pool &operator=(const worker_pool &) = delete;
+
+  /**
+   * @brief Queue a task without blocking
+   * @return false if the queue is full or the pool is stopped
+   */
+  bool try_submit(T _task) {
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      if (!running_ || size_ == slots_.size()) {
+        rejected_++;
+        return false;
+      }
+      slots_[(head_ + size_) % slots_.size()] = std::move(_task);
+      size_++;
+      if (size_ > max_size_)
+        max_size_ = size_;
+    }
+    submitted_++;
+    condition_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Stop the workers; tasks still queued are discarded
+   */
+  void stop() {
+    {
+      std::lock_guard<std::mutex> its_lock(mutex_);
+      if (!running_)
+        return;
+      running_ = false;
+    }
+    condition_.notify_all();
+    for (auto &its_worker : workers_) {
+      if (its_worker.joinable())
+        its_worker.join();
+    }
+  }
+
+  /// 当前队列长度
+  std::size_t queued() const {
+    std::lock_guard<std::mutex> its_lock(mutex_);
+    return size_;
+  }
+  /// 队列长度的历史最大值
+  std::size_t max_queued() const {
+    std::lock_guard<std::mutex> its_lock(mutex_);
+    return max_size_;
+  }
+  std::size_t queue_depth() const { return slots_.size(); }
+  std::size_t workers() const { return workers_.size(); }
+  uint64_t submitted() const { return submitted_; }
+  uint64_t rejected() const { return rejected_; }
+  uint64_t processed() const { return processed_; }
+
+private:
+  void run() {
+    T its_task;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> its_lock(mutex_);
+        condition_.wait(its_lock, [this] { return !running_ || size_ > 0; });
+        if (!running_)
+          return;
+        its_task = std::move(slots_[head_]);
+        slots_[head_] = T();
+        head_ = (head_ + 1) % slots_.size();
+        size_--;
+      }
+      handler_(its_task);
+      its_task = T();
+      processed_++;
+    }
+  }
+
+  handler_t handler_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  /// 环形队列，head_指向队首，size_为当前长度，受mutex_保护
+  std::vector<T> slots_;
+  std::size_t head_;
+  std::size_t size_;
+  bool running_;
+  std::size_t max_size_;
+
+  std::atomic<uint64_t> submitted_;
+  std::atomic<uint64_t> rejected_;
+  std::atomic<uint64_t> processed_;
+
+  std::vector<std::thread> workers_;
+};
+
+#endif // VSOMEIP_EXAMPLES_WORKER_POOL_HPP
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <csignal>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "async_logger.hpp"
+#include "request_sample.hpp"
+#include "response_example.hpp"
+#include "routing_sample.hpp"
+
+/**
+ * @brief 在一个进程中运行routing、response和request三个vsomeip::application
+ * @note 与分别启动routing/response/request使用相同的类和参数，用于对比
+ * 多进程布局下经过routing host转发的本地通信开销
+ * @note 不链接src/alloc_counter.cpp，三个应用都不统计分配次数，
+ * 不为单进程布局增加operator new的计数开销
+ * @note 配置参考config/all_in_one.json，routing必须是routing_example
+ * @note SIGINT/SIGTERM在所有线程中被屏蔽，由主线程sigwait统一停止三个应用；
+ * request按--duration结束时也会向本进程发送SIGTERM
+ */
+int main(int argc, char **argv) {
+  bool be_quiet = false;
+  uint32_t cycle = 1000; // Default: 1s
+  uint32_t inflight = 0; // Default: one request per cycle
+  uint32_t report_interval = 5000; // Default: 5s
+  uint32_t payload_size = 10;
+  uint32_t response_size = 120;
+  uint32_t duration = 0; // Default: run until stopped
+  uint32_t workers = 0;
+  uint32_t queue_depth = 1024;
+  std::string csv_path;
+  std::string csv_label("single");
+  bool use_shm = false;
+
+  std::string quiet_arg("--quiet");
+  std::string cycle_arg("--cycle");
+  std::string inflight_arg("--inflight");
+  std::string report_interval_arg("--report-interval");
+  std::string payload_size_arg("--payload-size");
+  std::string response_size_arg("--response-size");
+  std::string duration_arg("--duration");
+  std::string workers_arg("--workers");
+  std::string queue_depth_arg("--queue-depth");
+  std::string csv_arg("--csv");
+  std::string label_arg("--label");
+  std::string shm_arg("--shm");
+
+  bool has_response_size = false;
+  for (int i = 1; i < argc; i++) {
+    uint32_t *its_number = nullptr;
+    if (quiet_arg == argv[i]) {
+      be_quiet = true;
+      async_logger::get().set_level(log_level_e::LL_WARNING);
+    } else if (shm_arg == argv[i]) {
+      use_shm = true;
+    } else if (cycle_arg == argv[i] && i + 1 < argc) {
+      its_number = &cycle;
+    } else if (inflight_arg == argv[i] && i + 1 < argc) {
+      its_number = &inflight;
+    } else if (report_interval_arg == argv[i] && i + 1 < argc) {
+      its_number = &report_interval;
+    } else if (payload_size_arg == argv[i] && i + 1 < argc) {
+      its_number = &payload_size;
+    } else if (response_size_arg == argv[i] && i + 1 < argc) {
+      its_number = &response_size;
+      has_response_size = true;
+    } else if (duration_arg == argv[i] && i + 1 < argc) {
+      its_number = &duration;
+    } else if (workers_arg == argv[i] && i + 1 < argc) {
+      its_number = &workers;
+    } else if (queue_depth_arg == argv[i] && i + 1 < argc) {
+      its_number = &queue_depth;
+    } else if (csv_arg == argv[i] && i + 1 < argc) {
+      i++;
+      csv_path = argv[i];
+    } else if (label_arg == argv[i] && i + 1 < argc) {
+      i++;
+      csv_label = argv[i];
+    }
+    if (its_number) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> *its_number;
+    }
+  }
+  // 与someip_bench一致，默认响应与请求的payload一样大
+  if (!has_response_size)
+    response_size = payload_size;
+  if (inflight > 0xFFFE)
+    inflight = 0xFFFE;
+
+  // 必须在创建任何线程之前屏蔽信号，vsomeip的线程会继承该信号掩码
+  sigset_t its_signals;
+  sigemptyset(&its_signals);
+  sigaddset(&its_signals, SIGINT);
+  sigaddset(&its_signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &its_signals, nullptr);
+
+  routing_sample its_routing;
+  response_example its_response(false, "", workers, queue_depth,
+                                response_size, use_shm,
+                                std::max<uint32_t>(64, inflight));
+  request_sample its_request(true, be_quiet, cycle, "", inflight,
+                             report_interval, payload_size, duration, csv_path,
+                             csv_label, use_shm);
+
+  // routing host必须最先注册
+  if (!its_routing.init() || !its_response.init() || !its_request.init())
+    return 1;
+
+  std::thread its_routing_thread([&its_routing] { its_routing.start(); });
+  std::thread its_response_thread([&its_response] { its_response.start(); });
+  std::thread its_request_thread([&its_request] {
+    its_request.start();
+    // request按--duration自行停止后结束整个进程
+    kill(getpid(), SIGTERM);
+  });
+
+  int its_signal = 0;
+  sigwait(&its_signals, &its_signal);
+
+  its_request.stop();
+  its_request_thread.join();
+  its_response.stop();
+  its_response_thread.join();
+  its_routing.stop();
+  its_routing_thread.join();
+  return 0;
+}
@@ -0,0 +1,104 @@
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.hpp"
+
+/**
+ * @brief 替换全局的operator new/delete，统计分配次数
+ * @note 只链接进需要计数的可执行文件，定义必须只出现在一个翻译单元中
+ * @note 带大小、对齐或nothrow参数的delete都转发给对应的基本形式，
+ * 每种new只与一种释放方式配对
+ */
+
+namespace {
+
+void *allocate(std::size_t _size) {
+  alloc_counter::thread_allocations()++;
+  alloc_counter::total_allocations().fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(_size ? _size : 1);
+}
+
+void *allocate(std::size_t _size, std::align_val_t _align) {
+  alloc_counter::thread_allocations()++;
+  alloc_counter::total_allocations().fetch_add(1, std::memory_order_relaxed);
+  std::size_t its_align = static_cast<std::size_t>(_align);
+  std::size_t its_size = (_size + its_align - 1) / its_align * its_align;
+  return std::aligned_alloc(its_align, its_size ? its_size : its_align);
+}
+
+const bool kInstalled = (alloc_counter::is_installed() = true);
+
+} // namespace
+
+void *operator new(std::size_t _size) {
+  if (void *its_ptr = allocate(_size))
+    return its_ptr;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t _size) {
+  if (void *its_ptr = allocate(_size))
+    return its_ptr;
+  throw std::bad_alloc();
+}
+void *operator new(std::size_t _size, const std::nothrow_t &) noexcept {
+  return allocate(_size);
+}
+void *operator new[](std::size_t _size, const std::nothrow_t &) noexcept {
+  return allocate(_size);
+}
+void *operator new(std::size_t _size, std::align_val_t _align) {
+  if (void *its_ptr = allocate(_size, _align))
+    return its_ptr;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t _size, std::align_val_t _align) {
+  if (void *its_ptr = allocate(_size, _align))
+    return its_ptr;
+  throw std::bad_alloc();
+}
+void *operator new(std::size_t _size, std::align_val_t _align,
+                   const std::nothrow_t &) noexcept {
+  return allocate(_size, _align);
+}
+void *operator new[](std::size_t _size, std::align_val_t _align,
+                     const std::nothrow_t &) noexcept {
+  return allocate(_size, _align);
+}
+
+void operator delete(void *_ptr) noexcept { std::free(_ptr); }
+void operator delete[](void *_ptr) noexcept { std::free(_ptr); }
+void operator delete(void *_ptr, std::align_val_t) noexcept { std::free(_ptr); }
+void operator delete[](void *_ptr, std::align_val_t) noexcept {
+  std::free(_ptr);
+}
+
+void operator delete(void *_ptr, std::size_t) noexcept {
+  ::operator delete(_ptr);
+}
+void operator delete[](void *_ptr, std::size_t) noexcept {
+  ::operator delete[](_ptr);
+}
+void operator delete(void *_ptr, const std::nothrow_t &) noexcept {
+  ::operator delete(_ptr);
+}
+void operator delete[](void *_ptr, const std::nothrow_t &) noexcept {
+  ::operator delete[](_ptr);
+}
+void operator delete(void *_ptr, std::size_t _size,
+                     std::align_val_t _align) noexcept {
+  (void)_size;
+  ::operator delete(_ptr, _align);
+}
+void operator delete[](void *_ptr, std::size_t _size,
+                       std::align_val_t _align) noexcept {
+  (void)_size;
+  ::operator delete[](_ptr, _align);
+}
+void operator delete(void *_ptr, std::align_val_t _align,
+                     const std::nothrow_t &) noexcept {
+  ::operator delete(_ptr, _align);
+}
+void operator delete[](void *_ptr, std::align_val_t _align,
+                       const std::nothrow_t &) noexcept {
+  ::operator delete[](_ptr, _align);
+}
@@ -0,0 +1,124 @@
+// Microbenchmark: the iostream/unordered_map based header dump the samples
+// used to print in on_message, compared with message_formatter.
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vsomeip/vsomeip.hpp>
+
+#include "message_formatter.hpp"
+
+namespace {
+
+const std::unordered_map<vsomeip::message_type_e, std::string> message_map = {
+    {vsomeip::message_type_e::MT_REQUEST, "MT_REQUEST"},
+    {vsomeip::message_type_e::MT_NOTIFICATION, "MT_NOTIFICATION"},
+    {vsomeip::message_type_e::MT_RESPONSE, "MT_RESPONSE"},
+    {vsomeip::message_type_e::MT_ERROR, "MT_ERROR"},
+};
+
+const std::unordered_map<vsomeip::return_code_e, std::string> return_code_map =
+    {
+        {vsomeip::return_code_e::E_OK, "E_OK"},
+        {vsomeip::return_code_e::E_NOT_OK, "E_NOT_OK"},
+};
+
+/**
+ * @brief The formatting the handlers did before message_formatter existed.
+ */
+std::size_t format_legacy(const message_header &_header,
+                          const std::vector<vsomeip::byte_t> &_payload) {
+  std::stringstream ss;
+  ss << "Received a notify from "
+     << "service: " << std::hex << std::setfill('0') << std::setw(4)
+     << _header.service_ << ", instance: " << std::hex << std::setfill('0')
+     << std::setw(4) << _header.instance_ << ", client: " << std::hex
+     << std::setfill('0') << std::setw(4) << _header.client_
+     << ", method: " << std::hex << std::setfill('0') << std::setw(4)
+     << _header.method_ << ", session: " << _header.session_
+     << ", length: " << _header.length_
+     << ", protocol version: " << int(_header.protocol_version_)
+     << ", interface version: " << int(_header.interface_version_)
+     << ", message type: " << message_map.at(_header.message_type_)
+     << ", return code: " << return_code_map.at(_header.return_code_)
+     << ", is reliable: " << _header.is_reliable_
+     << ", is valid crc: " << _header.is_valid_crc_;
+  ss << ", payload (" << std::dec << _payload.size() << ") " << std::hex;
+  for (std::size_t i = 0; i < _payload.size(); ++i)
+    ss << std::setw(2) << static_cast<int>(_payload[i]) << " ";
+  return ss.str().size();
+}
+
+std::size_t format_new(message_formatter &_formatter,
+                       const message_header &_header,
+                       const std::vector<vsomeip::byte_t> &_payload) {
+  _formatter.clear();
+  _formatter.append_header("Received a notify from", _header)
+      .append_payload(_payload.data(), _payload.size(), _payload.size());
+  return _formatter.view().size();
+}
+
+template <typename Fn> double measure(uint32_t _iterations, Fn &&_fn) {
+  std::size_t its_sink = 0;
+  const auto its_start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < _iterations; ++i)
+    its_sink += _fn();
+  const auto its_elapsed = std::chrono::steady_clock::now() - its_start;
+  if (its_sink == 0)
+    std::cerr << "unexpected empty output" << std::endl;
+  return std::chrono::duration<double, std::nano>(its_elapsed).count() /
+         _iterations;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t iterations = 200000;
+
+  std::string iterations_arg("--iterations");
+
+  for (int i = 1; i < argc; i++) {
+    if (iterations_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> iterations;
+    }
+  }
+
+  const message_header its_header{0x1234,
+                                  0x5678,
+                                  0x0421,
+                                  0x1343,
+                                  0x0042,
+                                  128,
+                                  1,
+                                  0,
+                                  vsomeip::message_type_e::MT_RESPONSE,
+                                  vsomeip::return_code_e::E_OK,
+                                  true,
+                                  true};
+  message_formatter its_formatter;
+
+  std::cout << "payload_bytes,legacy_ns,formatter_ns,speedup" << std::endl;
+  for (std::size_t its_size : {0, 10, 120, 200}) {
+    std::vector<vsomeip::byte_t> its_payload(its_size);
+    for (std::size_t i = 0; i < its_size; ++i)
+      its_payload[i] = vsomeip::byte_t(i % 256);
+
+    const double its_legacy = measure(
+        iterations, [&] { return format_legacy(its_header, its_payload); });
+    const double its_new = measure(iterations, [&] {
+      return format_new(its_formatter, its_header, its_payload);
+    });
+    std::cout << std::fixed << std::setprecision(1) << its_size << ","
+              << its_legacy << "," << its_new << ","
+              << std::setprecision(2) << its_legacy / its_new << std::endl;
+  }
+  return 0;
+}
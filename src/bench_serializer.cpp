@@ -0,0 +1,261 @@
+// Microbenchmark: the hand-written byte loops the samples used to build and
+// parse payloads, compared with someip_serializer.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <vsomeip/vsomeip.hpp>
+
+#include "sample_header.hpp"
+#include "someip_serializer.hpp"
+
+namespace {
+
+struct sensor_sample {
+  uint64_t timestamp_;
+  std::array<int32_t, 4> channels_;
+};
+
+/// 大而定长的数组，例如一帧雷达或配置表
+struct table_sample {
+  uint32_t id_;
+  std::vector<uint32_t> entries_;
+};
+
+} // namespace
+
+template <> struct someip_serializer::layout<sensor_sample> {
+  static constexpr auto members = std::make_tuple(&sensor_sample::timestamp_,
+                                                  &sensor_sample::channels_);
+};
+
+template <> struct someip_serializer::layout<table_sample> {
+  static constexpr auto members =
+      std::make_tuple(&table_sample::id_, &table_sample::entries_);
+};
+
+namespace {
+
+/**
+ * @brief The byte loops the samples used before someip_serializer existed.
+ */
+void write_manual(vsomeip::byte_t *_data, uint64_t _value, int _size) {
+  for (int i = _size - 1; i >= 0; --i) {
+    _data[i] = static_cast<vsomeip::byte_t>(_value & 0xFF);
+    _value >>= 8;
+  }
+}
+
+uint64_t read_manual(const vsomeip::byte_t *_data, int _size) {
+  uint64_t its_value = 0;
+  for (int i = 0; i < _size; ++i)
+    its_value = (its_value << 8) | _data[i];
+  return its_value;
+}
+
+std::size_t encode_header_manual(const sample_header &_header,
+                                 std::vector<vsomeip::byte_t> &_out) {
+  write_manual(_out.data(), _header.sequence_, 8);
+  write_manual(_out.data() + 8, _header.timestamp_, 8);
+  return _out[15];
+}
+
+std::size_t encode_header_new(const sample_header &_header,
+                              std::vector<vsomeip::byte_t> &_out) {
+  _header.encode(_out.data());
+  return _out[15];
+}
+
+std::size_t decode_header_manual(const std::vector<vsomeip::byte_t> &_in) {
+  if (_in.size() < sample_header::kSize)
+    return 0;
+  return read_manual(_in.data(), 8) + read_manual(_in.data() + 8, 8);
+}
+
+std::size_t decode_header_new(const std::vector<vsomeip::byte_t> &_in) {
+  sample_header its_header;
+  if (!sample_header::decode(_in.data(), _in.size(), its_header))
+    return 0;
+  return its_header.sequence_ + its_header.timestamp_;
+}
+
+std::size_t decode_header_view(const std::vector<vsomeip::byte_t> &_in) {
+  someip_serializer::view<sample_header> its_view(_in.data(), _in.size());
+  return its_view.valid() ? its_view.get<0>() : 0;
+}
+
+std::size_t encode_sensor_manual(const sensor_sample &_sample,
+                                 std::vector<vsomeip::byte_t> &_out) {
+  _out.resize(8 + 4 * _sample.channels_.size());
+  write_manual(_out.data(), _sample.timestamp_, 8);
+  for (std::size_t c = 0; c < _sample.channels_.size(); ++c)
+    write_manual(_out.data() + 8 + c * 4,
+                 static_cast<uint32_t>(_sample.channels_[c]), 4);
+  return _out.size();
+}
+
+std::size_t encode_sensor_new(const sensor_sample &_sample,
+                              std::vector<vsomeip::byte_t> &_out) {
+  someip_serializer::serialize(_sample, _out);
+  return _out.size();
+}
+
+std::size_t encode_table_manual(const table_sample &_sample,
+                                std::vector<vsomeip::byte_t> &_out) {
+  _out.resize(8 + 4 * _sample.entries_.size());
+  write_manual(_out.data(), _sample.id_, 4);
+  write_manual(_out.data() + 4, 4 * _sample.entries_.size(), 4);
+  for (std::size_t i = 0; i < _sample.entries_.size(); ++i)
+    write_manual(_out.data() + 8 + i * 4, _sample.entries_[i], 4);
+  return _out.size();
+}
+
+std::size_t encode_table_new(const table_sample &_sample,
+                             std::vector<vsomeip::byte_t> &_out) {
+  someip_serializer::serialize(_sample, _out);
+  return _out.size();
+}
+
+std::size_t decode_table_manual(const std::vector<vsomeip::byte_t> &_in,
+                                table_sample &_sample) {
+  if (_in.size() < 8)
+    return 0;
+  _sample.id_ = static_cast<uint32_t>(read_manual(_in.data(), 4));
+  const std::size_t its_size = read_manual(_in.data() + 4, 4);
+  if (_in.size() - 8 < its_size || its_size % 4 != 0)
+    return 0;
+  _sample.entries_.resize(its_size / 4);
+  for (std::size_t i = 0; i < _sample.entries_.size(); ++i)
+    _sample.entries_[i] =
+        static_cast<uint32_t>(read_manual(_in.data() + 8 + i * 4, 4));
+  return _sample.entries_.size();
+}
+
+std::size_t decode_table_new(const std::vector<vsomeip::byte_t> &_in,
+                             table_sample &_sample) {
+  if (!someip_serializer::deserialize(_in.data(), _in.size(), _sample))
+    return 0;
+  return _sample.entries_.size();
+}
+
+template <typename Fn> double measure(uint32_t _iterations, Fn &&_fn) {
+  std::size_t its_sink = 0;
+  const auto its_start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < _iterations; ++i)
+    its_sink += _fn(i);
+  const auto its_elapsed = std::chrono::steady_clock::now() - its_start;
+  if (its_sink == 0)
+    std::cerr << "unexpected empty output" << std::endl;
+  return std::chrono::duration<double, std::nano>(its_elapsed).count() /
+         _iterations;
+}
+
+void print_row(const std::string &_case, double _manual, double _new) {
+  std::cout << _case << "," << std::fixed << std::setprecision(1) << _manual
+            << "," << _new << "," << std::setprecision(2) << _manual / _new
+            << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t iterations = 1000000;
+  uint32_t table_entries = 1024;
+
+  std::string iterations_arg("--iterations");
+  std::string table_entries_arg("--table-entries");
+
+  for (int i = 1; i < argc; i++) {
+    if (iterations_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> iterations;
+    } else if (table_entries_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> table_entries;
+    }
+  }
+
+  std::vector<vsomeip::byte_t> its_buffer(sample_header::kSize);
+  sensor_sample its_sensor{0x0123456789ABCDEFull, {1000, 2000, 3000, 4000}};
+  table_sample its_table{42, std::vector<uint32_t>(table_entries)};
+  for (uint32_t i = 0; i < table_entries; ++i)
+    its_table.entries_[i] = i * 2654435761u;
+  std::vector<vsomeip::byte_t> its_encoded;
+  someip_serializer::serialize(its_table, its_encoded);
+  table_sample its_decoded;
+
+  std::cout << "case,manual_ns,serializer_ns,speedup" << std::endl;
+  print_row("sample_header encode",
+            measure(iterations,
+                    [&](uint32_t i) {
+                      return encode_header_manual({i + 1, i}, its_buffer);
+                    }),
+            measure(iterations, [&](uint32_t i) {
+              return encode_header_new({i + 1, i}, its_buffer);
+            }));
+  // 解码前每次修改输入，避免编译器把解码移出循环
+  print_row("sample_header decode",
+            measure(iterations,
+                    [&](uint32_t i) {
+                      its_buffer[7] = static_cast<vsomeip::byte_t>(i);
+                      return decode_header_manual(its_buffer);
+                    }),
+            measure(iterations,
+                    [&](uint32_t i) {
+                      its_buffer[7] = static_cast<vsomeip::byte_t>(i);
+                      return decode_header_new(its_buffer);
+                    }));
+  print_row("sample_header view",
+            measure(iterations,
+                    [&](uint32_t i) {
+                      its_buffer[7] = static_cast<vsomeip::byte_t>(i);
+                      return decode_header_manual(its_buffer);
+                    }),
+            measure(iterations,
+                    [&](uint32_t i) {
+                      its_buffer[7] = static_cast<vsomeip::byte_t>(i);
+                      return decode_header_view(its_buffer);
+                    }));
+  print_row("sensor encode",
+            measure(iterations,
+                    [&](uint32_t i) {
+                      its_sensor.timestamp_ = i;
+                      return encode_sensor_manual(its_sensor, its_buffer);
+                    }),
+            measure(iterations, [&](uint32_t i) {
+              its_sensor.timestamp_ = i;
+              return encode_sensor_new(its_sensor, its_buffer);
+            }));
+
+  // 表的迭代次数按条目数缩小，保持运行时间相近
+  const uint32_t its_table_iterations =
+      std::max<uint32_t>(1, iterations / std::max<uint32_t>(1, table_entries));
+  std::vector<vsomeip::byte_t> its_table_buffer;
+  print_row("table encode",
+            measure(its_table_iterations,
+                    [&](uint32_t) {
+                      return encode_table_manual(its_table, its_table_buffer);
+                    }),
+            measure(its_table_iterations, [&](uint32_t) {
+              return encode_table_new(its_table, its_table_buffer);
+            }));
+  print_row("table decode",
+            measure(its_table_iterations,
+                    [&](uint32_t) {
+                      return decode_table_manual(its_encoded, its_decoded);
+                    }),
+            measure(its_table_iterations, [&](uint32_t) {
+              return decode_table_new(its_encoded, its_decoded);
+            }));
+  return 0;
+}
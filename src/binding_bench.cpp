@@ -0,0 +1,555 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <vsomeip/vsomeip.hpp>
+
+#include "bench_process.hpp"
+#include "sample_ids.hpp"
+
+/**
+ * @brief 绑定层开销的基准测试：同一个echo负载分别经过原生vsomeip
+ * (response/request)和CommonAPI(HelloWorldService/HelloWorldClient)，
+ * 比较每次调用的延时、吞吐量和CPU时间
+ * @note 与someip_bench的network布局相同：服务端节点127.0.0.1、客户端节点
+ * 127.0.0.2，各自运行一个routing，关闭service discovery，两种绑定都使用TCP
+ * @note 每个payload大小先运行HelloWorldClient --serialize-only，得到sayHello
+ * 序列化后的请求和响应字节数及序列化耗时；原生vsomeip使用相同的字节数
+ * @note 每次调用的CPU时间是两个节点所有进程的CPU时间之和除以调用数。
+ * payload_us_per_call是单线程循环测得的一次调用中构造请求和响应payload的
+ * 耗时，范围为应用数据到vsomeip::message的payload再读回应用数据，两种绑定
+ * 相同；消息头和payload写成报文发生在application::send中，两种绑定都计入
+ * 分发(dispatch)：发送、routing转发、接收和回调
+ * @note 两种绑定的payload_us_per_call并不对称：CommonAPI需要把std::string
+ * 编码为UTF-16LE，原生vsomeip的应用数据本身就是字节，只有拷贝。
+ * request/response示例复用同一个payload，负载运行中没有这部分开销，
+ * 因此raw的dispatch_us_per_call不扣除它
+ */
+
+namespace {
+
+const char *kServerAddress = "127.0.0.1";
+const char *kClientAddress = "127.0.0.2";
+/// SOME/IP头部长度
+const uint32_t kHeaderSize = 16;
+/// HelloWorld.fdepl中的服务、实例和端口
+const char *kHelloWorldService = "0x1234";
+const char *kHelloWorldInstance = "0x1234";
+const char *kHelloWorldPort = "30499";
+/// CommonAPI的interface和instance，用于生成commonapi.ini
+const char *kHelloWorldAddress = "local:commonapi.examples.HelloWorld:v0_1:"
+                                 "commonapi.examples.HelloWorld";
+
+struct bench_options {
+  std::string bin_dir_;
+  /// libHelloWorld-someip.so所在的目录
+  std::string lib_dir_;
+  std::string template_;
+  std::string work_dir_;
+  std::string output_;
+  std::vector<uint32_t> sizes_;
+  std::vector<uint32_t> inflights_;
+  uint32_t duration_;
+  /// 客户端在duration_之后仍未退出时的额外等待时间，单位s
+  uint32_t grace_;
+  /// 序列化测量的循环次数，不能为0
+  uint32_t iterations_;
+};
+
+/// 一种绑定下一个payload大小的序列化结果
+struct payload_shape {
+  uint32_t request_bytes_;
+  uint32_t response_bytes_;
+  /// 一次调用构造请求和响应payload的耗时，单位ns
+  double payload_ns_;
+  /// payload_ns_是否包含在负载运行的CPU时间中
+  bool in_run_;
+};
+
+/**
+ * @brief Write the configuration of one node derived from the template
+ * @note 在模板的服务之外加入HelloWorld服务，两者都位于服务端节点
+ * @param _max_payload 需要支持的最大payload
+ */
+bool write_config(const bench_options &_options, const std::string &_path,
+                  const std::string &_unicast, const std::string &_network,
+                  uint32_t _max_payload) {
+  namespace pt = boost::property_tree;
+  pt::ptree its_config;
+  try {
+    pt::read_json(_options.template_, its_config);
+  } catch (const pt::json_parser_error &e) {
+    std::cerr << "Couldn't read " << _options.template_ << ": " << e.what()
+              << std::endl;
+    return false;
+  }
+
+  its_config.put("unicast", _unicast);
+  its_config.put("network", _network);
+  its_config.put("routing", "routing_example");
+  its_config.put("logging.level", "warning");
+  its_config.put("logging.file.enable", "false");
+  its_config.put("logging.dlt", "false");
+  its_config.put("service-discovery.enable", "false");
+
+  pt::ptree its_services = its_config.get_child("services", pt::ptree());
+  for (auto &its_service : its_services)
+    its_service.second.put("unicast", kServerAddress);
+  pt::ptree its_hello_world;
+  its_hello_world.put("service", kHelloWorldService);
+  its_hello_world.put("instance", kHelloWorldInstance);
+  its_hello_world.put("unicast", kServerAddress);
+  its_hello_world.put("reliable.port", kHelloWorldPort);
+  its_hello_world.put("reliable.enable-magic-cookies", "false");
+  its_services.push_back(std::make_pair("", its_hello_world));
+  its_config.put_child("services", its_services);
+
+  const std::string its_limit = std::to_string(_max_payload + kHeaderSize);
+  its_config.put("max-payload-size-local", its_limit);
+  its_config.put("max-payload-size-reliable", its_limit);
+
+  try {
+    pt::write_json(_path, its_config);
+  } catch (const pt::json_parser_error &e) {
+    std::cerr << "Couldn't write " << _path << ": " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Write the CommonAPI configuration used by both HelloWorld processes
+ * @note 使用SOME/IP绑定，并指定生成的libHelloWorld-someip.so
+ */
+bool write_commonapi_ini(const bench_options &_options,
+                         const std::string &_path) {
+  std::ofstream its_ini(_path);
+  if (!its_ini) {
+    std::cerr << "Couldn't write " << _path << std::endl;
+    return false;
+  }
+  const std::string its_library =
+      _options.lib_dir_ + "/libHelloWorld-someip.so";
+  its_ini << "[default]\nbinding=someip\n\n"
+          << "[logging]\nconsole=false\ndlt=false\nlevel=warning\n\n"
+          << "[proxy]\n" << kHelloWorldAddress << "=" << its_library << "\n\n"
+          << "[stub]\n" << kHelloWorldAddress << "=" << its_library << "\n";
+  return true;
+}
+
+/**
+ * @brief Payload cost of one raw vsomeip call
+ * @note 与HelloWorldClient的measureSerialization范围相同：创建请求、把应用
+ * 数据复制进payload、服务端复制出来，响应同样处理一次。应用数据已经是字节，
+ * 因此只有拷贝，没有编码
+ * @return 每次调用的平均耗时，单位ns
+ */
+double measure_raw_payload(uint32_t _request_bytes, uint32_t _response_bytes,
+                           uint32_t _iterations) {
+  std::shared_ptr<vsomeip::runtime> its_runtime = vsomeip::runtime::get();
+  std::vector<vsomeip::byte_t> its_request_data(_request_bytes);
+  std::vector<vsomeip::byte_t> its_response_data(_response_bytes);
+  for (std::size_t i = 0; i < its_request_data.size(); ++i)
+    its_request_data[i] = vsomeip::byte_t(i % 256);
+  for (std::size_t i = 0; i < its_response_data.size(); ++i)
+    its_response_data[i] = vsomeip::byte_t(i % 256);
+  std::vector<vsomeip::byte_t> its_received;
+
+  std::size_t its_sink = 0;
+  const auto its_start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < _iterations; ++i) {
+    std::shared_ptr<vsomeip::message> its_request =
+        its_runtime->create_request(true);
+    its_request->set_service(RequestResponse_SERVICE_ID);
+    its_request->set_instance(RequestResponse_INSTANCE_ID);
+    its_request->set_method(RequestResponse_METHOD_ID);
+    std::shared_ptr<vsomeip::payload> its_payload =
+        its_runtime->create_payload();
+    its_payload->set_data(its_request_data);
+    its_request->set_payload(its_payload);
+    its_payload = its_request->get_payload();
+    its_received.assign(its_payload->get_data(),
+                        its_payload->get_data() + its_payload->get_length());
+    its_sink += its_received.size();
+
+    std::shared_ptr<vsomeip::message> its_response =
+        its_runtime->create_response(its_request);
+    its_payload = its_runtime->create_payload();
+    its_payload->set_data(its_response_data);
+    its_response->set_payload(its_payload);
+    its_payload = its_response->get_payload();
+    its_received.assign(its_payload->get_data(),
+                        its_payload->get_data() + its_payload->get_length());
+    its_sink += its_received.size();
+  }
+  const auto its_elapsed = std::chrono::steady_clock::now() - its_start;
+  if (its_sink == 0)
+    std::cerr << "unexpected empty output" << std::endl;
+  return std::chrono::duration<double, std::nano>(its_elapsed).count() /
+         _iterations;
+}
+
+/**
+ * @brief Measure the sayHello payload of one size with HelloWorldClient
+ * @return false if HelloWorldClient did not report a result
+ */
+bool measure_commonapi_serialization(const bench_options &_options,
+                                     uint32_t _size, payload_shape &_shape) {
+  const std::string its_csv_path = _options.work_dir_ + "/serialize.csv";
+  const std::string its_log = _options.work_dir_ + "/bench.log";
+  std::remove(its_csv_path.c_str());
+
+  const pid_t its_client = bench_process::spawn(
+      _options.bin_dir_ + "/HelloWorldClient",
+      {"--serialize-only", "--payload-size", std::to_string(_size),
+       "--serialize-iterations", std::to_string(_options.iterations_), "--csv",
+       its_csv_path},
+      _options.work_dir_ + "/client.json", its_log);
+  double its_cpu = 0;
+  if (its_client <= 0 ||
+      !bench_process::wait_for(
+          its_client, std::chrono::seconds(_options.grace_), its_cpu)) {
+    bench_process::terminate(its_client, its_cpu);
+    return false;
+  }
+
+  std::ifstream its_csv(its_csv_path);
+  std::string its_header, its_row;
+  if (!std::getline(its_csv, its_header) || !std::getline(its_csv, its_row))
+    return false;
+  const double its_request =
+      bench_process::csv_column(its_header, its_row, "payload_bytes");
+  const double its_response =
+      bench_process::csv_column(its_header, its_row, "response_bytes");
+  _shape.payload_ns_ =
+      bench_process::csv_column(its_header, its_row, "serialize_ns");
+  _shape.in_run_ = true;
+  if (its_request < 0 || its_response < 0 || _shape.payload_ns_ < 0)
+    return false;
+  _shape.request_bytes_ = static_cast<uint32_t>(its_request);
+  _shape.response_bytes_ = static_cast<uint32_t>(its_response);
+  return true;
+}
+
+/**
+ * @brief Append one result row built from the client's CSV to the output
+ * @param _client_cpu 客户端节点的CPU时间，包括routing
+ * @param _server_cpu 服务端节点的CPU时间，包括routing
+ */
+void append_result(const bench_options &_options, const std::string &_binding,
+                   const std::string &_run, const payload_shape &_shape,
+                   double _client_cpu, double _server_cpu) {
+  std::ifstream its_run(_run);
+  std::string its_header, its_row;
+  if (!std::getline(its_run, its_header) || !std::getline(its_run, its_row))
+    return;
+  auto column = [&its_header, &its_row](const char *_name) {
+    return bench_process::csv_column(its_header, its_row, _name);
+  };
+
+  const double its_calls = column("responses");
+  const double its_cpu_us =
+      its_calls > 0 ? (_client_cpu + _server_cpu) * 1e6 / its_calls : 0.0;
+  const double its_payload_us = _shape.payload_ns_ / 1000.0;
+  const double its_dispatch_us =
+      its_cpu_us - (_shape.in_run_ ? its_payload_us : 0.0);
+
+  const bool is_new = !std::ifstream(_options.output_).good();
+  std::ofstream its_output(_options.output_, std::ios::app);
+  if (is_new)
+    its_output << "binding,request_bytes,response_bytes,inflight,duration_s,"
+                  "calls,throughput_cps,mean_us,p50_us,p99_us,max_us,"
+                  "cpu_client_s,cpu_server_s,cpu_us_per_call,"
+                  "payload_us_per_call,dispatch_us_per_call\n";
+  its_output << _binding << "," << _shape.request_bytes_ << ","
+             << _shape.response_bytes_ << ","
+             << static_cast<uint32_t>(column("inflight")) << std::fixed
+             << std::setprecision(3) << "," << column("duration_s") << ","
+             << static_cast<uint64_t>(std::max(its_calls, 0.0)) << ","
+             << column("throughput_rps") << "," << column("mean_us") << ","
+             << column("p50_us") << "," << column("p99_us") << ","
+             << column("max_us") << "," << _client_cpu << "," << _server_cpu
+             << "," << its_cpu_us << "," << its_payload_us << ","
+             << std::max(its_dispatch_us, 0.0) << "\n";
+}
+
+/**
+ * @brief Run one binding with one payload shape and append its result row
+ * @param _binding raw: response/request；commonapi: HelloWorldService/
+ * HelloWorldClient
+ * @param _size 传给HelloWorldClient的--payload-size，_shape由它得出
+ * @return false if the client did not finish in time
+ */
+bool run_once(const bench_options &_options, const std::string &_binding,
+              uint32_t _size, const payload_shape &_shape,
+              uint32_t _inflight) {
+  const std::string its_server_config = _options.work_dir_ + "/server.json";
+  const std::string its_client_config = _options.work_dir_ + "/client.json";
+  const std::string its_log = _options.work_dir_ + "/bench.log";
+  const std::string its_run = _options.work_dir_ + "/run.csv";
+  const std::string its_inflight = std::to_string(_inflight);
+  const std::string its_duration = std::to_string(_options.duration_);
+  // 只在结束时输出一次统计
+  const std::string its_report_interval =
+      std::to_string(_options.duration_ * 1000);
+  std::remove(its_run.c_str());
+
+  {
+    std::ofstream its_out(its_log, std::ios::app);
+    its_out << "=== " << _binding << " request=" << _shape.request_bytes_
+            << " response=" << _shape.response_bytes_
+            << " inflight=" << _inflight << " ===" << std::endl;
+  }
+
+  std::string its_server_binary, its_client_binary;
+  std::vector<std::string> its_server_args, its_client_args;
+  if (_binding == "commonapi") {
+    its_server_binary = _options.bin_dir_ + "/HelloWorldService";
+    its_server_args = {"--quiet"};
+    its_client_binary = _options.bin_dir_ + "/HelloWorldClient";
+    its_client_args = {"--load",
+                       "--concurrency",
+                       its_inflight,
+                       "--duration",
+                       its_duration,
+                       "--report-interval",
+                       its_report_interval,
+                       "--payload-size",
+                       std::to_string(_size),
+                       "--csv",
+                       its_run,
+                       "--label",
+                       _binding};
+  } else {
+    its_server_binary = _options.bin_dir_ + "/response";
+    its_server_args = {"--quiet", "--static-routing", "--payload-size",
+                       std::to_string(_shape.response_bytes_)};
+    its_client_binary = _options.bin_dir_ + "/request";
+    its_client_args = {"--quiet",
+                       "--inflight",
+                       its_inflight,
+                       "--duration",
+                       its_duration,
+                       "--report-interval",
+                       its_report_interval,
+                       "--payload-size",
+                       std::to_string(_shape.request_bytes_),
+                       "--csv",
+                       its_run,
+                       "--label",
+                       _binding};
+  }
+
+  // 除客户端外的进程，second为true表示属于服务端节点
+  std::vector<std::pair<pid_t, bool>> its_services;
+  its_services.emplace_back(bench_process::spawn(_options.bin_dir_ + "/routing",
+                                                 {}, its_server_config,
+                                                 its_log),
+                            true);
+  its_services.emplace_back(bench_process::spawn(_options.bin_dir_ + "/routing",
+                                                 {}, its_client_config,
+                                                 its_log),
+                            false);
+  // routing必须先于应用启动，否则应用会自己成为routing host
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  its_services.emplace_back(bench_process::spawn(its_server_binary,
+                                                 its_server_args,
+                                                 its_server_config, its_log),
+                            true);
+  const pid_t its_client = bench_process::spawn(
+      its_client_binary, its_client_args, its_client_config, its_log);
+
+  double its_client_cpu = 0, its_server_cpu = 0;
+  bool is_finished = true;
+  if (its_client > 0 &&
+      !bench_process::wait_for(
+          its_client,
+          std::chrono::seconds(_options.duration_ + _options.grace_),
+          its_client_cpu)) {
+    std::cerr << _binding << " client did not finish, see " << its_log
+              << std::endl;
+    bench_process::terminate(its_client, its_client_cpu);
+    is_finished = false;
+  }
+  // 与启动顺序相反：先停止应用，再停止routing
+  for (auto its_pid = its_services.rbegin(); its_pid != its_services.rend();
+       ++its_pid)
+    bench_process::terminate(its_pid->first,
+                             its_pid->second ? its_server_cpu : its_client_cpu);
+
+  if (is_finished)
+    append_result(_options, _binding, its_run, _shape, its_client_cpu,
+                  its_server_cpu);
+  return is_finished && its_client > 0;
+}
+
+void print_usage(const char *_name) {
+  std::cout
+      << "Usage: " << _name << " [options]\n"
+      << "  --bin-dir DIR       directory of routing/request/response and "
+         "HelloWorldService/HelloWorldClient "
+         "(default: directory of this program)\n"
+      << "  --lib-dir DIR       directory of libHelloWorld-someip.so "
+         "(default: BIN_DIR/../lib)\n"
+      << "  --config FILE       template configuration "
+         "(default: config/request_response.json)\n"
+      << "  --work-dir DIR      generated configurations and logs "
+         "(default: /tmp/binding_bench)\n"
+      << "  --output FILE       result CSV, truncated at start "
+         "(default: binding_bench.csv)\n"
+      << "  --sizes LIST        sayHello request payload sizes in bytes "
+         "(default: 16,256,4096,65536)\n"
+      << "  --inflight LIST     calls in flight (default: 1,16)\n"
+      << "  --duration S        seconds per run (default: 5)\n"
+      << "  --grace S           extra seconds before a run is killed "
+         "(default: 15)\n"
+      << "  --iterations N      serialization loop iterations, at least 1 "
+         "(default: 100000)\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench_options its_options;
+  its_options.bin_dir_ = bench_process::executable_dir();
+  its_options.template_ = "config/request_response.json";
+  its_options.work_dir_ = "/tmp/binding_bench";
+  its_options.output_ = "binding_bench.csv";
+  its_options.sizes_ = {16, 256, 4096, 65536};
+  its_options.inflights_ = {1, 16};
+  its_options.duration_ = 5;
+  its_options.grace_ = 15;
+  its_options.iterations_ = 100000;
+
+  std::string bin_dir_arg("--bin-dir");
+  std::string lib_dir_arg("--lib-dir");
+  std::string config_arg("--config");
+  std::string work_dir_arg("--work-dir");
+  std::string output_arg("--output");
+  std::string sizes_arg("--sizes");
+  std::string inflight_arg("--inflight");
+  std::string duration_arg("--duration");
+  std::string grace_arg("--grace");
+  std::string iterations_arg("--iterations");
+  std::string help_arg("--help");
+
+  for (int i = 1; i < argc; i++) {
+    uint32_t *its_number = nullptr;
+    if (help_arg == argv[i]) {
+      print_usage(argv[0]);
+      return 0;
+    } else if (bin_dir_arg == argv[i] && i + 1 < argc) {
+      its_options.bin_dir_ = argv[++i];
+    } else if (lib_dir_arg == argv[i] && i + 1 < argc) {
+      its_options.lib_dir_ = argv[++i];
+    } else if (config_arg == argv[i] && i + 1 < argc) {
+      its_options.template_ = argv[++i];
+    } else if (work_dir_arg == argv[i] && i + 1 < argc) {
+      its_options.work_dir_ = argv[++i];
+    } else if (output_arg == argv[i] && i + 1 < argc) {
+      its_options.output_ = argv[++i];
+    } else if (sizes_arg == argv[i] && i + 1 < argc) {
+      its_options.sizes_ = bench_process::parse_list<uint32_t>(argv[++i]);
+    } else if (inflight_arg == argv[i] && i + 1 < argc) {
+      its_options.inflights_ = bench_process::parse_list<uint32_t>(argv[++i]);
+    } else if (duration_arg == argv[i] && i + 1 < argc) {
+      its_number = &its_options.duration_;
+    } else if (grace_arg == argv[i] && i + 1 < argc) {
+      its_number = &its_options.grace_;
+    } else if (iterations_arg == argv[i] && i + 1 < argc) {
+      its_number = &its_options.iterations_;
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+    if (its_number) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> *its_number;
+    }
+  }
+  if (its_options.duration_ == 0)
+    its_options.duration_ = 1;
+  if (its_options.iterations_ == 0) {
+    std::cerr << "--iterations must be at least 1" << std::endl;
+    return 1;
+  }
+  if (its_options.lib_dir_.empty())
+    its_options.lib_dir_ = its_options.bin_dir_ + "/../lib";
+
+  if (mkdir(its_options.work_dir_.c_str(), 0755) < 0 && errno != EEXIST) {
+    std::cerr << "Couldn't create " << its_options.work_dir_ << ": "
+              << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  std::remove(its_options.output_.c_str());
+
+  // 响应"Hello name!"只比name的utf16le编码多几个字节，留出一个头部的余量
+  uint32_t its_max_payload = 0;
+  for (uint32_t its_size : its_options.sizes_)
+    its_max_payload = std::max(its_max_payload, its_size);
+  its_max_payload += kHeaderSize;
+  const std::string its_ini = its_options.work_dir_ + "/commonapi.ini";
+  if (!write_config(its_options, its_options.work_dir_ + "/server.json",
+                    kServerAddress, "vsomeip_binding_server",
+                    its_max_payload) ||
+      !write_config(its_options, its_options.work_dir_ + "/client.json",
+                    kClientAddress, "vsomeip_binding_client",
+                    its_max_payload) ||
+      !write_commonapi_ini(its_options, its_ini))
+    return 1;
+  // 子进程继承环境变量
+  setenv("COMMONAPI_CONFIG", its_ini.c_str(), 1);
+
+  uint32_t its_failed = 0;
+  for (uint32_t its_size : its_options.sizes_) {
+    payload_shape its_commonapi;
+    if (!measure_commonapi_serialization(its_options, its_size,
+                                         its_commonapi)) {
+      std::cerr << "Couldn't measure sayHello serialization for payload="
+                << its_size << std::endl;
+      its_failed++;
+      continue;
+    }
+    // 原生vsomeip发送与sayHello相同字节数的请求和响应
+    payload_shape its_raw = its_commonapi;
+    its_raw.payload_ns_ =
+        measure_raw_payload(its_raw.request_bytes_, its_raw.response_bytes_,
+                            its_options.iterations_);
+    its_raw.in_run_ = false;
+
+    for (uint32_t its_inflight : its_options.inflights_) {
+      its_inflight = std::max<uint32_t>(its_inflight, 1);
+      std::cerr << "request=" << its_commonapi.request_bytes_
+                << " response=" << its_commonapi.response_bytes_
+                << " inflight=" << its_inflight << std::endl;
+      if (!run_once(its_options, "raw", its_size, its_raw, its_inflight))
+        its_failed++;
+      if (!run_once(its_options, "commonapi", its_size, its_commonapi,
+                    its_inflight))
+        its_failed++;
+    }
+  }
+
+  std::ifstream its_result(its_options.output_);
+  std::cout << its_result.rdbuf();
+  if (its_failed > 0)
+    std::cerr << its_failed << " runs did not finish" << std::endl;
+  return its_failed > 0 ? 1 : 0;
+}
@@ -9,20 +9,40 @@
 #include <condition_variable>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include <vsomeip/vsomeip.hpp>
 
+#include "async_logger.hpp"
+#include "delta_codec.hpp"
+#include "message_formatter.hpp"
 #include "sample_ids.hpp"
+#include "someip_serializer.hpp"
 #include "type_map.hpp"
 
 class field_client_example {
 public:
-  field_client_example(bool _use_tcp)
+  /**
+   * @param _use_tcp Use TCP or not.
+   * @param _cycle 读取field的周期，单位ms
+   * @param _set_every 每读取N次SET一次新值，0表示只读
+   * @param _delta notification是增量编码的值，与field_server的--delta一致；
+   * GET/SET的响应仍然是完整值
+   */
+  field_client_example(bool _use_tcp, uint32_t _cycle = 1000,
+                       uint32_t _set_every = 0, bool _delta = false)
       : app_(vsomeip::runtime::get()->create_application(
             "field_client_example")),
-        use_tcp_(_use_tcp) {}
+        use_tcp_(_use_tcp), cycle_(_cycle), set_every_(_set_every),
+        delta_(_delta), running_(true), is_available_(false),
+        is_cached_(false), is_get_pending_(false), is_resync_pending_(false),
+        reads_(0), hits_(0), get_round_trips_(0), set_round_trips_(0),
+        notifications_(0), keyframes_(0), deltas_(0), gaps_(0),
+        notification_bytes_(0),
+        reader_thread_(std::bind(&field_client_example::run, this)) {}
 
   bool init() {
     if (!app_->init()) {
@@ -58,6 +78,19 @@ public:
   void start() { app_->start(); }
 
   void stop() {
+    {
+      std::lock_guard<std::mutex> its_lock(cache_mutex_);
+      running_ = false;
+    }
+    cache_condition_.notify_all();
+    if (std::this_thread::get_id() != reader_thread_.get_id()) {
+      if (reader_thread_.joinable()) {
+        reader_thread_.join();
+      }
+    } else {
+      reader_thread_.detach();
+    }
+    print_statistics();
     app_->clear_all_handler();
     app_->unsubscribe(FieldClient_SERVICE_ID, FieldClient_INSTANCE_ID,
                       FieldClient_EVENTGROUP_ID);
@@ -80,59 +113,304 @@ public:
 
   void on_availability(vsomeip::service_t _service,
                        vsomeip::instance_t _instance, bool _is_available) {
-    std::cout << "Service [" << std::hex << std::setfill('0') << std::setw(4)
-              << _service << "." << _instance << "] is "
-              << (_is_available ? "available." : "NOT available.") << std::endl;
+    message_formatter its_formatter;
+    its_formatter.append_availability(_service, _instance, _is_available);
+    std::cout << its_formatter.view() << std::endl;
+
+    if (_service == FieldClient_SERVICE_ID &&
+        _instance == FieldClient_INSTANCE_ID) {
+      std::lock_guard<std::mutex> its_lock(cache_mutex_);
+      is_available_ = _is_available;
+      if (!_is_available) {
+        // 服务消失后不会再收到notification，缓存的值可能过期
+        is_cached_ = false;
+        is_get_pending_ = false;
+        is_resync_pending_ = false;
+      }
+      cache_condition_.notify_all();
+    }
   }
 
+  /**
+   * @brief Notifications and GET/SET responses all refresh the cache
+   */
   void on_message(const std::shared_ptr<vsomeip::message> &_response) {
-    std::stringstream ss;
-    ss << "Received a notify from "
-       << "service: " << std::hex << std::setfill('0') << std::setw(4)
-       << _response->get_service() << ", instance: " << std::hex
-       << std::setfill('0') << std::setw(4) << _response->get_instance()
-       << ", client: " << std::hex << std::setfill('0') << std::setw(4)
-       << _response->get_client() << ", method: " << std::hex
-       << std::setfill('0') << std::setw(4) << _response->get_method()
-       << ", message: " << _response->get_message()
-       << ", length: " << _response->get_length()
-       << ", request: " << _response->get_request()
-       << ", session: " << _response->get_session()
-       << ", protocol version: " << _response->get_protocol_version()
-       << ", interface version: " << _response->get_interface_version()
-       << ", message type: " << message_map.at(_response->get_message_type())
-       << ", return code: " << return_code_map.at(_response->get_return_code())
-       << ", is reliable: " << _response->is_reliable()
-       << ", is valid crc: " << _response->is_valid_crc();
-    std::cout << ss.str() << std::endl;
-
-    std::stringstream its_message;
-    its_message << "Received a notification for Event [" << std::hex
-                << std::setfill('0') << std::setw(4) << _response->get_service()
-                << "." << std::setw(4) << _response->get_instance() << "."
-                << std::setw(4) << _response->get_method()
-                << "] to Client/Session [" << std::setw(4)
-                << _response->get_client() << "/" << std::setw(4)
-                << _response->get_session() << "] = ";
-
-    std::shared_ptr<vsomeip::payload> its_payload = _response->get_payload();
-    its_message << "(" << std::dec << its_payload->get_length() << ") "
-                << std::hex;
-    for (uint32_t i = 0; i < its_payload->get_length(); ++i)
-      its_message << std::setw(2)
-                  << static_cast<int>(its_payload->get_data()[i]) << " ";
-    std::cout << its_message.str() << std::endl;
+    const vsomeip::message_type_e its_type = _response->get_message_type();
+    const vsomeip::method_t its_method = _response->get_method();
+    if (its_type == vsomeip::message_type_e::MT_NOTIFICATION) {
+      async_logger::get().log_message(log_level_e::LL_INFO,
+                                      "Received a notification from",
+                                      _response, true);
+      if (its_method == FieldClient_EVENT_ID) {
+        if (delta_)
+          apply_delta(_response->get_payload());
+        else
+          update_cache(_response->get_payload(), true);
+      }
+    } else if (its_type == vsomeip::message_type_e::MT_RESPONSE &&
+               (its_method == FieldClient_GET_METHOD_ID ||
+                its_method == FieldClient_SET_METHOD_ID)) {
+      async_logger::get().log_message(log_level_e::LL_INFO,
+                                      "Received a response from", _response,
+                                      true);
+      update_cache(_response->get_payload(), false);
+    } else {
+      async_logger::get().log_message(log_level_e::LL_WARNING,
+                                      "Received an unexpected message from",
+                                      _response, true);
+      if (its_method == FieldClient_GET_METHOD_ID) {
+        std::lock_guard<std::mutex> its_lock(cache_mutex_);
+        is_get_pending_ = false;
+        cache_condition_.notify_all();
+      }
+    }
+  }
+
+  /**
+   * @brief Read the field, from the cache if a value is known
+   * @note 已订阅且收到过notification(或GET/SET响应)时直接返回缓存的值，
+   * 否则发送GET并等待响应，最多等待_timeout
+   * @return false表示服务不可用或GET超时
+   */
+  bool read_field(std::vector<vsomeip::byte_t> &_value,
+                  std::chrono::milliseconds _timeout) {
+    std::unique_lock<std::mutex> its_lock(cache_mutex_);
+    reads_++;
+    if (is_cached_) {
+      hits_++;
+      _value = cache_;
+      return true;
+    }
+    if (!is_available_)
+      return false;
+    if (!is_get_pending_) {
+      is_get_pending_ = true;
+      get_round_trips_++;
+      its_lock.unlock();
+      send_request(FieldClient_GET_METHOD_ID, nullptr, 0);
+      its_lock.lock();
+    }
+    cache_condition_.wait_for(its_lock, _timeout, [this] {
+      return is_cached_ || !is_get_pending_ || !running_;
+    });
+    if (!is_cached_) {
+      is_get_pending_ = false;
+      return false;
+    }
+    _value = cache_;
+    return true;
+  }
+
+  /**
+   * @brief SET a new value, the cache is updated from the response
+   */
+  void write_field(const std::vector<vsomeip::byte_t> &_value) {
+    {
+      std::lock_guard<std::mutex> its_lock(cache_mutex_);
+      set_round_trips_++;
+    }
+    send_request(FieldClient_SET_METHOD_ID, _value.data(), _value.size());
+  }
+
+  /**
+   * @brief Read the field every cycle and SET a new value every set_every_ reads
+   */
+  void run() {
+    std::vector<vsomeip::byte_t> its_value;
+    uint32_t its_set_value = 0;
+    uint64_t count = 0;
+    auto its_last_report = std::chrono::steady_clock::now();
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> its_lock(cache_mutex_);
+        cache_condition_.wait(its_lock,
+                              [this] { return is_available_ || !running_; });
+        if (!running_)
+          break;
+      }
+
+      if (read_field(its_value, std::chrono::milliseconds(1000))) {
+        message_formatter its_formatter;
+        its_formatter.append("Field value (")
+            .append_dec(its_value.size())
+            .append(") ")
+            .append_hex_dump(its_value.data(), its_value.size(), 32);
+        std::cout << its_formatter.view() << std::endl;
+      } else {
+        std::cout << "Field value not available" << std::endl;
+      }
+
+      count++;
+      if (set_every_ > 0 && count % set_every_ == 0) {
+        its_set_value++;
+        std::vector<vsomeip::byte_t> its_new_value;
+        someip_serializer::serialize(its_set_value, its_new_value);
+        write_field(its_new_value);
+      }
+
+      const auto its_now = std::chrono::steady_clock::now();
+      if (its_now - its_last_report >= std::chrono::seconds(5)) {
+        print_statistics();
+        its_last_report = its_now;
+      }
+
+      std::unique_lock<std::mutex> its_lock(cache_mutex_);
+      cache_condition_.wait_for(its_lock, std::chrono::milliseconds(cycle_),
+                                [this] { return !running_; });
+    }
   }
 
 private:
+  /**
+   * @brief Apply a delta encoded notification to the cache
+   * @note 检测到丢帧(基准不一致)时缓存失效，读取退回到GET，并请求服务端
+   * 发送keyframe；在收到keyframe之前只请求一次
+   */
+  void apply_delta(const std::shared_ptr<vsomeip::payload> &_payload) {
+    bool is_resync_needed = false;
+    {
+      std::lock_guard<std::mutex> its_lock(cache_mutex_);
+      notifications_++;
+      notification_bytes_ += _payload->get_length();
+      switch (decoder_.apply(_payload->get_data(), _payload->get_length())) {
+      case delta_codec::apply_result_e::AR_KEYFRAME:
+        keyframes_++;
+        is_resync_pending_ = false;
+        break;
+      case delta_codec::apply_result_e::AR_DELTA:
+        deltas_++;
+        break;
+      default:
+        gaps_++;
+        is_cached_ = false;
+        is_resync_needed = !is_resync_pending_;
+        is_resync_pending_ = true;
+        break;
+      }
+      if (decoder_.has_value()) {
+        cache_ = decoder_.value();
+        is_cached_ = true;
+        is_get_pending_ = false;
+        cache_condition_.notify_all();
+      }
+    }
+    if (is_resync_needed)
+      send_resync();
+  }
+
+  /// 请求服务端notify一个keyframe，不需要响应
+  void send_resync() {
+    std::shared_ptr<vsomeip::message> its_request =
+        vsomeip::runtime::get()->create_request(use_tcp_);
+    its_request->set_service(FieldClient_SERVICE_ID);
+    its_request->set_instance(FieldClient_INSTANCE_ID);
+    its_request->set_method(FieldClient_RESYNC_METHOD_ID);
+    its_request->set_message_type(
+        vsomeip::message_type_e::MT_REQUEST_NO_RETURN);
+    app_->send(its_request);
+  }
+
+  void update_cache(const std::shared_ptr<vsomeip::payload> &_payload,
+                    bool _is_notification) {
+    std::lock_guard<std::mutex> its_lock(cache_mutex_);
+    if (_is_notification)
+      notifications_++;
+    cache_.assign(_payload->get_data(),
+                  _payload->get_data() + _payload->get_length());
+    is_cached_ = true;
+    is_get_pending_ = false;
+    cache_condition_.notify_all();
+  }
+
+  void send_request(vsomeip::method_t _method, const vsomeip::byte_t *_data,
+                    std::size_t _length) {
+    std::shared_ptr<vsomeip::message> its_request =
+        vsomeip::runtime::get()->create_request(use_tcp_);
+    its_request->set_service(FieldClient_SERVICE_ID);
+    its_request->set_instance(FieldClient_INSTANCE_ID);
+    its_request->set_method(_method);
+    its_request->set_payload(vsomeip::runtime::get()->create_payload(
+        _data, static_cast<uint32_t>(_length)));
+    app_->send(its_request);
+  }
+
+  void print_statistics() {
+    std::lock_guard<std::mutex> its_lock(cache_mutex_);
+    std::cout << "Field cache: reads=" << std::dec << reads_
+              << ", cache hits=" << hits_
+              << " (round trips avoided), GET round trips=" << get_round_trips_
+              << ", SET round trips=" << set_round_trips_
+              << ", notifications=" << notifications_;
+    if (delta_)
+      std::cout << " (keyframes=" << keyframes_ << ", deltas=" << deltas_
+                << ", gaps=" << gaps_ << ", bytes=" << notification_bytes_
+                << ")";
+    std::cout << std::endl;
+  }
+
   std::shared_ptr<vsomeip::application> app_;
   bool use_tcp_;
+  uint32_t cycle_;
+  uint32_t set_every_;
+  bool delta_;
+
+  /// 以下成员只在持有cache_mutex_时访问
+  std::mutex cache_mutex_;
+  std::condition_variable cache_condition_;
+  bool running_;
+  bool is_available_;
+  bool is_cached_;
+  bool is_get_pending_;
+  bool is_resync_pending_;
+  std::vector<vsomeip::byte_t> cache_;
+  delta_codec::decoder decoder_;
+  uint64_t reads_;
+  uint64_t hits_;
+  uint64_t get_round_trips_;
+  uint64_t set_round_trips_;
+  uint64_t notifications_;
+  uint64_t keyframes_;
+  uint64_t deltas_;
+  /// 无法应用的增量帧数，每次都会使缓存失效
+  uint64_t gaps_;
+  uint64_t notification_bytes_;
+
+  // running_ / is_available_ must be initialized before starting the thread!
+  std::thread reader_thread_;
 };
 
 int main(int argc, char **argv) {
   bool use_tcp = true;
 
-  field_client_example its_sample(use_tcp);
+  uint32_t cycle = 1000; // default 1s
+  uint32_t set_every = 0;
+  bool delta = false;
+
+  std::string quiet_arg("--quiet");
+  std::string cycle_arg("--cycle");
+  std::string set_every_arg("--set-every");
+  std::string delta_arg("--delta");
+
+  for (int i = 1; i < argc; i++) {
+    if (quiet_arg == argv[i]) {
+      async_logger::get().set_level(log_level_e::LL_WARNING);
+    } else if (delta_arg == argv[i]) {
+      delta = true;
+    } else if (cycle_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> cycle;
+    } else if (set_every_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> set_every;
+    }
+  }
+
+  field_client_example its_sample(use_tcp, cycle, set_every, delta);
   if (its_sample.init()) {
     its_sample.start();
     return 0;
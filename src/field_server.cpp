@@ -5,28 +5,79 @@
 #ifndef VSOMEIP_ENABLE_SIGNAL_HANDLING
 #include <csignal>
 #endif
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <random>
 #include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <vsomeip/vsomeip.hpp>
 
+#include "delta_codec.hpp"
+#include "epsilon_change.hpp"
 #include "sample_ids.hpp"
+#include "someip_serializer.hpp"
+#include "triple_buffer.hpp"
 #include "type_map.hpp"
 
+/// 示例传感器的field值
+struct sensor_sample {
+  static constexpr std::size_t kChannels = 4;
+
+  /// 生成时间，单位ms
+  uint64_t timestamp_;
+  std::array<int32_t, kChannels> channels_;
+};
+
+template <> struct someip_serializer::layout<sensor_sample> {
+  static constexpr auto members = std::make_tuple(&sensor_sample::timestamp_,
+                                                  &sensor_sample::channels_);
+};
+
 class field_server_example {
 public:
-  field_server_example()
+  /**
+   * @param _cycle 生产和notify的周期，单位ms
+   * @param _comparator field的epsilon比较器：none(vsomeip默认的逐字节比较)、
+   * exact、tolerance、masked，见epsilon_change.hpp
+   * @param _tolerance tolerance比较器允许的最大差值
+   * @param _sensor 生成带时间戳和噪声的传感器样本，代替固定的两组数据
+   * @param _produce 是否启动示例生产者线程；为false时field只能通过SET修改
+   * @param _table_size 大于0时生成该大小、每周期只改变一个条目的配置表，
+   * 代替固定的两组数据
+   * @param _delta notify增量编码的值(见delta_codec.hpp)，与field_client的
+   * --delta一致
+   * @param _keyframe_interval 增量编码时每N次notify至少发送一次完整值
+   */
+  field_server_example(uint32_t _cycle = 1000,
+                       const std::string &_comparator = "none",
+                       int32_t _tolerance = 6, bool _sensor = false,
+                       bool _produce = true, uint32_t _table_size = 0,
+                       bool _delta = false, uint32_t _keyframe_interval = 50)
       : app_(vsomeip::runtime::get()->create_application(
             "field_server_example")),
-        is_registered_(false), cycle_(1000), blocked_(false), running_(true),
+        is_registered_(false), cycle_(_cycle), comparator_(_comparator),
+        tolerance_(_tolerance), sensor_(_sensor), produce_(_produce),
+        table_size_(_table_size), delta_(_delta),
+        counters_(std::make_shared<epsilon_change::counters>()),
+        updates_(0), gets_(0), sets_(0), resyncs_(0),
+        encoder_(_keyframe_interval),
+        delta_payload_(vsomeip::runtime::get()->create_payload()),
+        blocked_(false), running_(true),
         is_offered_(false),
+        samples_(std::vector<vsomeip::byte_t>(kSensorSize)),
         offer_thread_(std::bind(&field_server_example::run, this)),
-        notify_thread_(std::bind(&field_server_example::notify, this)) {}
+        notify_thread_(std::bind(&field_server_example::notify, this)),
+        produce_thread_(std::bind(&field_server_example::produce, this)) {}
 
   bool init() {
     std::lock_guard<std::mutex> its_lock(mutex_);
@@ -38,18 +89,40 @@ public:
     app_->register_state_handler(std::bind(&field_server_example::on_state,
                                            this, std::placeholders::_1));
 
+    app_->register_message_handler(
+        FieldClient_SERVICE_ID, FieldClient_INSTANCE_ID,
+        FieldClient_GET_METHOD_ID,
+        std::bind(&field_server_example::on_get, this, std::placeholders::_1));
+    app_->register_message_handler(
+        FieldClient_SERVICE_ID, FieldClient_INSTANCE_ID,
+        FieldClient_SET_METHOD_ID,
+        std::bind(&field_server_example::on_set, this, std::placeholders::_1));
+    app_->register_message_handler(
+        FieldClient_SERVICE_ID, FieldClient_INSTANCE_ID,
+        FieldClient_RESYNC_METHOD_ID,
+        std::bind(&field_server_example::on_resync, this,
+                  std::placeholders::_1));
+
     std::set<vsomeip::eventgroup_t> its_groups;
     its_groups.insert(FieldClient_EVENTGROUP_ID);
 
+    vsomeip::epsilon_change_func_t its_comparator = make_comparator();
+    if (!its_comparator && comparator_ != "none") {
+      std::cerr << "Unknown comparator " << comparator_
+                << ", expected none|exact|tolerance|masked" << std::endl;
+      return false;
+    }
+    // 增量帧带有序号，每一帧都不同，比较器只能作用于原始值
+    if (delta_ && comparator_ != "none") {
+      std::cerr << "--delta requires --comparator none" << std::endl;
+      return false;
+    }
     app_->offer_event(FieldClient_SERVICE_ID, FieldClient_INSTANCE_ID,
                       FieldClient_EVENT_ID, its_groups,
                       vsomeip::event_type_e::ET_FIELD,
-                      std::chrono::milliseconds::zero(), false, true, nullptr,
-                      vsomeip::reliability_type_e::RT_RELIABLE);
-    {
-      std::lock_guard<std::mutex> its_lock(payload_mutex_);
-      payload_ = vsomeip::runtime::get()->create_payload();
-    }
+                      std::chrono::milliseconds::zero(), false, true,
+                      its_comparator, vsomeip::reliability_type_e::RT_RELIABLE);
+    payload_ = vsomeip::runtime::get()->create_payload();
 
     blocked_ = true;
     condition_.notify_one();
@@ -79,6 +152,14 @@ public:
     } else {
       notify_thread_.detach();
     }
+    if (std::this_thread::get_id() != produce_thread_.get_id()) {
+      if (produce_thread_.joinable()) {
+        produce_thread_.join();
+      }
+    } else {
+      produce_thread_.detach();
+    }
+    print_statistics();
     app_->stop();
   }
 
@@ -122,54 +203,302 @@ public:
     }
   }
 
-  void notify() {
+  /**
+   * @brief Example producer: toggles the field value every 5 cycles.
+   * @note 只负责生成新值，通过samples_交给notify线程，不等待notify完成
+   */
+  void produce() {
+    if (!produce_)
+      return;
+    if (sensor_) {
+      produce_sensor();
+      return;
+    }
+    if (table_size_ > 0) {
+      produce_table();
+      return;
+    }
+
     vsomeip::byte_t its_data1[10] = {0x00, 0x00, 0x00, 0x00, 0x00,
                                      0x00, 0x00, 0x00, 0x00, 0x00};
     vsomeip::byte_t its_data2[5] = {0x11, 0x11, 0x11, 0x11, 0x11};
     std::uint32_t count(0);
     bool its_data1_flag(true);
 
+    while (running_) {
+      std::vector<vsomeip::byte_t> &its_sample = samples_.write_buffer();
+      if (its_data1_flag) {
+        its_sample.assign(its_data1, its_data1 + sizeof(its_data1));
+      } else {
+        its_sample.assign(its_data2, its_data2 + sizeof(its_data2));
+      }
+      samples_.publish();
+
+      if (count % 5 == 0) {
+        if (its_data1_flag) {
+          its_data1_flag = false;
+        } else {
+          its_data1_flag = true;
+        }
+      }
+
+      count++;
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(cycle_));
+    }
+  }
+
+  /**
+   * @brief Example noisy sensor: timestamp + kChannels big-endian int32 values.
+   * @note 每个通道在基准值附近抖动±3，每50个样本其中一个通道跳变100，
+   * 用于比较不同epsilon比较器能抑制多少notification
+   */
+  void produce_sensor() {
+    std::minstd_rand its_random(42);
+    std::uniform_int_distribution<int32_t> its_noise(-3, 3);
+    int32_t its_base[kChannels] = {1000, 2000, 3000, 4000};
+    std::uint32_t count(0);
+
+    while (running_) {
+      if (count % 50 == 49)
+        its_base[(count / 50) % kChannels] += 100;
+
+      sensor_sample its_sample;
+      its_sample.timestamp_ = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+              .count());
+      for (std::size_t c = 0; c < kChannels; ++c)
+        its_sample.channels_[c] = its_base[c] + its_noise(its_random);
+      someip_serializer::serialize(its_sample, samples_.write_buffer());
+      samples_.publish();
+
+      count++;
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(cycle_));
+    }
+  }
+
+  /**
+   * @brief Example configuration table: table_size_ bytes of 4-byte entries,
+   * one random entry changes per cycle
+   * @note 大而变化缓慢的field，用于评估增量编码节省的带宽
+   */
+  void produce_table() {
+    std::minstd_rand its_random(42);
+    std::vector<vsomeip::byte_t> its_table(table_size_);
+    for (vsomeip::byte_t &its_byte : its_table)
+      its_byte = static_cast<vsomeip::byte_t>(its_random());
+
+    while (running_) {
+      const std::size_t its_entry = its_random() % ((table_size_ + 3) / 4);
+      for (std::size_t i = its_entry * 4;
+           i < std::min<std::size_t>(its_entry * 4 + 4, table_size_); ++i)
+        its_table[i] = static_cast<vsomeip::byte_t>(its_random());
+
+      samples_.write_buffer() = its_table;
+      samples_.publish();
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(cycle_));
+    }
+  }
+
+  void notify() {
+    std::uint32_t count(0);
+    auto its_last_report = std::chrono::steady_clock::now();
+
     while (running_) {
       std::unique_lock<std::mutex> its_lock(notify_mutex_);
       while (!is_offered_ && running_)
         notify_condition_.wait(its_lock);
       while (is_offered_ && running_) {
-        {
-          std::lock_guard<std::mutex> its_lock(payload_mutex_);
-
-          if (its_data1_flag) {
-            payload_->set_data(its_data1, 10);
-            std::cout << "Notify: num " << count << " times"
-                      << ", with payload: 10 bytes" << std::endl;
-          } else {
-            payload_->set_data(its_data2, 5);
+        if (samples_.update()) {
+          const std::vector<vsomeip::byte_t> &its_sample =
+              samples_.read_buffer();
+          payload_->set_data(its_sample.data(),
+                             static_cast<vsomeip::length_t>(its_sample.size()));
+          if (!sensor_ && table_size_ == 0) {
             std::cout << "Notify: num " << count << " times"
-                      << ", with payload: 5 bytes" << std::endl;
+                      << ", with payload: " << its_sample.size() << " bytes"
+                      << std::endl;
           }
 
-          app_->notify(FieldClient_SERVICE_ID, FieldClient_INSTANCE_ID,
-                       FieldClient_EVENT_ID, payload_);
+          update_value(payload_);
+          count++;
         }
 
-        if (count % 5 == 0) {
-          if (its_data1_flag) {
-            its_data1_flag = false;
-          } else {
-            its_data1_flag = true;
-          }
+        const auto its_now = std::chrono::steady_clock::now();
+        if ((sensor_ || table_size_ > 0) &&
+            its_now - its_last_report >= std::chrono::seconds(5)) {
+          print_statistics();
+          its_last_report = its_now;
         }
 
-        count++;
-
         std::this_thread::sleep_for(std::chrono::milliseconds(cycle_));
       }
     }
   }
 
+  /**
+   * @brief GET: respond with the current field value
+   */
+  void on_get(const std::shared_ptr<vsomeip::message> &_request) {
+    std::shared_ptr<vsomeip::message> its_response =
+        vsomeip::runtime::get()->create_response(_request);
+    {
+      std::lock_guard<std::mutex> its_lock(value_mutex_);
+      its_response->set_payload(
+          vsomeip::runtime::get()->create_payload(value_));
+    }
+    gets_.fetch_add(1, std::memory_order_relaxed);
+    app_->send(its_response);
+  }
+
+  /**
+   * @brief SET: take the requested value, notify subscribers and respond
+   * with the value that was set
+   */
+  void on_set(const std::shared_ptr<vsomeip::message> &_request) {
+    std::shared_ptr<vsomeip::payload> its_payload =
+        vsomeip::runtime::get()->create_payload(
+            _request->get_payload()->get_data(),
+            _request->get_payload()->get_length());
+    update_value(its_payload);
+    sets_.fetch_add(1, std::memory_order_relaxed);
+
+    std::shared_ptr<vsomeip::message> its_response =
+        vsomeip::runtime::get()->create_response(_request);
+    its_response->set_payload(its_payload);
+    app_->send(its_response);
+  }
+
+  /**
+   * @brief RESYNC: a client lost track of the deltas, notify a keyframe
+   * @note 所有订阅者都会收到这个keyframe
+   */
+  void on_resync(const std::shared_ptr<vsomeip::message> &_request) {
+    (void)_request;
+    resyncs_.fetch_add(1, std::memory_order_relaxed);
+    if (!delta_)
+      return;
+    std::lock_guard<std::mutex> its_lock(value_mutex_);
+    // 还没有notify过时，第一次notify本来就是keyframe
+    if (encoder_.keyframes() == 0)
+      return;
+    encoder_.force_keyframe();
+    notify_delta();
+  }
+
 private:
+  /**
+   * @brief Make _payload the current value and notify it
+   * @note notify线程和SET(dispatcher线程)都会调用，value_mutex_保证value_是
+   * 最后一次更新的值
+   * @note 比较器在app_->notify内部决定是否发送，被抑制的更新同样写入value_，
+   * 因此GET可能返回比最后一次notification更新的值
+   */
+  void update_value(const std::shared_ptr<vsomeip::payload> &_payload) {
+    std::lock_guard<std::mutex> its_lock(value_mutex_);
+    updates_.fetch_add(1, std::memory_order_relaxed);
+    if (delta_) {
+      // 与vsomeip默认的比较一致，值不变时不notify
+      if (encoder_.keyframes() > 0 &&
+          value_.size() == _payload->get_length() &&
+          std::equal(value_.begin(), value_.end(), _payload->get_data()))
+        return;
+      value_.assign(_payload->get_data(),
+                    _payload->get_data() + _payload->get_length());
+      notify_delta();
+      return;
+    }
+    value_.assign(_payload->get_data(),
+                  _payload->get_data() + _payload->get_length());
+    app_->notify(FieldClient_SERVICE_ID, FieldClient_INSTANCE_ID,
+                 FieldClient_EVENT_ID, _payload);
+  }
+
+  /// 编码并notify value_，调用者必须持有value_mutex_
+  void notify_delta() {
+    const std::vector<vsomeip::byte_t> &its_frame =
+        encoder_.encode(value_.data(), value_.size());
+    delta_payload_->set_data(its_frame.data(),
+                             static_cast<vsomeip::length_t>(its_frame.size()));
+    app_->notify(FieldClient_SERVICE_ID, FieldClient_INSTANCE_ID,
+                 FieldClient_EVENT_ID, delta_payload_);
+  }
+
+  /**
+   * @brief Build the comparator named by comparator_, wrapped with counters_
+   * @return nullptr表示使用vsomeip默认的比较(none或未知的名字)
+   */
+  vsomeip::epsilon_change_func_t make_comparator() const {
+    // 传感器样本的时间戳每次都变，tolerance/masked需要跳过它
+    const std::size_t its_skip = sensor_ ? kTimestampSize : 0;
+    vsomeip::epsilon_change_func_t its_comparator;
+    if (comparator_ == "exact") {
+      its_comparator = epsilon_change::exact();
+    } else if (comparator_ == "tolerance") {
+      its_comparator =
+          epsilon_change::numeric_tolerance<int32_t>(tolerance_, its_skip);
+    } else if (comparator_ == "masked") {
+      its_comparator = epsilon_change::masked(
+          epsilon_change::ignore_range(0, its_skip));
+    }
+    if (!its_comparator)
+      return nullptr;
+    return epsilon_change::counted(its_comparator, counters_);
+  }
+
+  void print_statistics() {
+    std::cout << "Field updates (" << comparator_ << "): notify=" << std::dec
+              << updates_.load(std::memory_order_relaxed)
+              << ", GET=" << gets_.load(std::memory_order_relaxed)
+              << ", SET=" << sets_.load(std::memory_order_relaxed);
+    if (comparator_ != "none") {
+      std::cout << ", sent=" << counters_->sent_.load(std::memory_order_relaxed)
+                << ", suppressed="
+                << counters_->suppressed_.load(std::memory_order_relaxed);
+    }
+    if (delta_) {
+      std::lock_guard<std::mutex> its_lock(value_mutex_);
+      std::cout << ", keyframes=" << encoder_.keyframes()
+                << ", deltas=" << encoder_.deltas()
+                << ", bytes=" << encoder_.encoded_bytes() << "/"
+                << encoder_.full_bytes()
+                << ", resyncs=" << resyncs_.load(std::memory_order_relaxed);
+    }
+    std::cout << std::endl;
+  }
+
+  /// 传感器样本：8字节时间戳(ms) + kChannels个int32
+  static constexpr std::size_t kTimestampSize = 8;
+  static constexpr std::size_t kChannels = sensor_sample::kChannels;
+  static constexpr std::size_t kSensorSize =
+      someip_serializer::fixed_size<sensor_sample>();
+
   std::shared_ptr<vsomeip::application> app_;
   bool is_registered_;
   uint32_t cycle_;
+  std::string comparator_;
+  int32_t tolerance_;
+  bool sensor_;
+  bool produce_;
+  uint32_t table_size_;
+  bool delta_;
+  /// 比较器的发送/抑制计数
+  std::shared_ptr<epsilon_change::counters> counters_;
+  /// notify()的调用次数
+  std::atomic<uint64_t> updates_;
+  std::atomic<uint64_t> gets_;
+  std::atomic<uint64_t> sets_;
+  std::atomic<uint64_t> resyncs_;
+
+  /// 最后一次SET或生产者更新的field值，不论是否被比较器抑制，GET直接返回它
+  std::mutex value_mutex_;
+  std::vector<vsomeip::byte_t> value_;
+  /// 以下成员只在持有value_mutex_时访问
+  delta_codec::encoder encoder_;
+  std::shared_ptr<vsomeip::payload> delta_payload_;
 
   std::mutex mutex_;
   std::condition_variable condition_;
@@ -180,16 +509,72 @@ private:
   std::condition_variable notify_condition_;
   bool is_offered_;
 
-  std::mutex payload_mutex_;
+  /// 只由notify线程访问
   std::shared_ptr<vsomeip::payload> payload_;
+  /// 生产者与notify线程之间传递最新的field值
+  triple_buffer<std::vector<vsomeip::byte_t>> samples_;
 
   // blocked_ / is_offered_ must be initialized before starting the threads!
   std::thread offer_thread_;
   std::thread notify_thread_;
+  std::thread produce_thread_;
 };
 
 int main(int argc, char **argv) {
-  field_server_example its_sample;
+  uint32_t cycle = 1000; // default 1s
+  std::string comparator("none");
+  int32_t tolerance = 6; // peak-to-peak noise of the example sensor
+  bool sensor = false;
+  bool produce = true;
+  uint32_t table_size = 0;
+  bool delta = false;
+  uint32_t keyframe_interval = 50;
+
+  std::string cycle_arg("--cycle");
+  std::string comparator_arg("--comparator");
+  std::string tolerance_arg("--tolerance");
+  std::string sensor_arg("--sensor");
+  std::string no_producer_arg("--no-producer");
+  std::string table_arg("--table");
+  std::string delta_arg("--delta");
+  std::string keyframe_arg("--keyframe-interval");
+
+  for (int i = 1; i < argc; i++) {
+    if (cycle_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> cycle;
+    } else if (comparator_arg == argv[i] && i + 1 < argc) {
+      i++;
+      comparator = argv[i];
+    } else if (tolerance_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> tolerance;
+    } else if (sensor_arg == argv[i]) {
+      sensor = true;
+    } else if (no_producer_arg == argv[i]) {
+      produce = false;
+    } else if (table_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> table_size;
+    } else if (delta_arg == argv[i]) {
+      delta = true;
+    } else if (keyframe_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> keyframe_interval;
+    }
+  }
+
+  field_server_example its_sample(cycle, comparator, tolerance, sensor,
+                                  produce, table_size, delta,
+                                  keyframe_interval);
   if (its_sample.init()) {
     its_sample.start();
     return 0;
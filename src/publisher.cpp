@@ -5,6 +5,7 @@
 #ifndef VSOMEIP_ENABLE_SIGNAL_HANDLING
 #include <csignal>
 #endif
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <iomanip>
@@ -12,10 +13,18 @@
 #include <mutex>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include <vsomeip/vsomeip.hpp>
 
+#include "batch_codec.hpp"
+#include "event_range.hpp"
+#include "latency_histogram.hpp"
+#include "rate_pacer.hpp"
+#include "sample_header.hpp"
 #include "sample_ids.hpp"
+#include "shm_channel.hpp"
+#include "triple_buffer.hpp"
 #include "type_map.hpp"
 
 /**
@@ -26,13 +35,59 @@ public:
   /**
    * @brief Construct the publisher example.
    * @param _cycle Cycle time.
+   * @param _rate 目标发布速率(msgs/s)，0表示按_cycle发布
+   * @param _burst 每个截止时间连续发布的消息数
+   * @param _spin_us 截止时间前忙等的时长，单位us
+   * @param _produce_rate 示例生产者线程生成样本的速率(msgs/s)，0表示与发布速率相同
+   * @param _events offer的event数，ID从PublishSubscribe_EVENT_ID开始连续分配
+   * @param _eventgroups event分布到的eventgroup数
+   * @param _notify_all 每次发布时notify所有event，否则按轮询每次notify一个
+   * @param _seq_header 在payload开头加上sample_header(序号+发送时间)
+   * @param _use_tcp event的可靠性类型，true为RT_RELIABLE，false为RT_UNRELIABLE
+   * @param _payload_size 示例生产者生成固定长度的样本，0表示生成1~9字节的样本。
+   * 使用UDP时超过一个报文的样本需要在配置中为event启用SOME/IP-TP，
+   * config/publish_subscribe.json只为前kTpEvents个event启用
+   * @param _use_shm 样本写入共享内存，notification只携带shm_descriptor；
+   * 仅适用于同一主机上的subscriber
+   * @param _shm_slots 共享内存的槽位数
+   * @param _batch_count 大于1时把每个event的多个样本打包成一个notification，
+   * 最多包含_batch_count个样本
+   * @param _batch_bytes 一个batch payload的最大字节数
+   * @param _batch_delay_us batch中第一个样本最多等待的时间，单位us。
+   * 按_cycle发布时notify线程在最早的batch截止时间醒来发送；按_rate发布时
+   * 只在每个截止时间检查，实际上限为max(_batch_delay_us, 1/_rate)
    */
-  publisher_example(uint32_t _cycle)
+  publisher_example(uint32_t _cycle, double _rate = 0, uint32_t _burst = 1,
+                    uint32_t _spin_us = 0, double _produce_rate = 0,
+                    uint32_t _events = 1, uint32_t _eventgroups = 1,
+                    bool _notify_all = false, bool _seq_header = false,
+                    bool _use_tcp = true, uint32_t _payload_size = 0,
+                    bool _use_shm = false, uint32_t _shm_slots = 16,
+                    uint32_t _batch_count = 0, uint32_t _batch_bytes = 1400,
+                    uint32_t _batch_delay_us = 200)
       : app_(vsomeip::runtime::get()->create_application("publisher_example")),
-        is_registered_(false), cycle_(_cycle), blocked_(false), running_(true),
-        is_offered_(false),
+        is_registered_(false), cycle_(_cycle), rate_(_rate), burst_(_burst),
+        spin_us_(_spin_us),
+        produce_rate_(_produce_rate > 0 ? _produce_rate
+                      : _rate > 0       ? _rate
+                                        : 1000.0 / (_cycle > 0 ? _cycle : 1)),
+        events_(PublishSubscribe_EVENT_ID, _events,
+                PublishSubscribe_EVENTGROUP_ID, _eventgroups),
+        notify_all_(_notify_all), next_event_(0), seq_header_(_seq_header),
+        use_tcp_(_use_tcp), payload_size_(_payload_size), use_shm_(_use_shm),
+        shm_slots_(_shm_slots), sequences_(events_.events(), 0),
+        framed_(sample_header::kSize),
+        batches_(make_batches(_batch_count, events_.events(), _batch_bytes,
+                              _batch_delay_us)),
+        batch_payload_(vsomeip::runtime::get()->create_payload()),
+        batches_sent_(0), batched_samples_(0), flushed_full_(0),
+        flushed_bytes_(0), flushed_delay_(0), flushed_stop_(0), blocked_(false),
+        running_(true), is_offered_(false),
+        samples_(std::vector<vsomeip::byte_t>(
+            std::max<std::size_t>(kMaxSampleSize, _payload_size))),
         offer_thread_(std::bind(&publisher_example::run, this)),
-        notify_thread_(std::bind(&publisher_example::notify, this)) {}
+        notify_thread_(std::bind(&publisher_example::notify, this)),
+        produce_thread_(std::bind(&publisher_example::produce, this)) {}
 
   /**
    * @brief Initialize the publisher example.
@@ -48,8 +103,12 @@ public:
     app_->register_state_handler(
         std::bind(&publisher_example::on_state, this, std::placeholders::_1));
 
-    std::set<vsomeip::eventgroup_t> its_groups;
-    its_groups.insert(PublishSubscribe_EVENTGROUP_ID);
+    // 段ID使用进程号，subscriber根据描述符中的段ID打开共享内存
+    if (use_shm_ &&
+        !shm_.open(static_cast<uint32_t>(getpid()), shm_slots_,
+                   static_cast<uint32_t>(
+                       std::max<std::size_t>(kMaxSampleSize, payload_size_))))
+      return false;
 
     /**
      * @brief Offer the event.
@@ -72,15 +131,28 @@ public:
      * @param _reliability
      * 可靠性类型，默认为RT_UNKNOWN。设计上不是RT_UNRELIABLE，就是RT_RELIABLE。并且同一个eventgroup中的event需要可靠性类型一致
      */
-    app_->offer_event(PublishSubscribe_SERVICE_ID, PublishSubscribe_INSTANCE_ID,
-                      PublishSubscribe_EVENT_ID, its_groups,
-                      vsomeip::event_type_e::ET_EVENT,
-                      std::chrono::milliseconds::zero(), false, true, nullptr,
-                      vsomeip::reliability_type_e::RT_RELIABLE);
-    {
-      std::lock_guard<std::mutex> its_lock(payload_mutex_);
-      payload_ = vsomeip::runtime::get()->create_payload();
+    for (uint32_t i = 0; i < events_.events(); ++i) {
+      app_->offer_event(PublishSubscribe_SERVICE_ID,
+                        PublishSubscribe_INSTANCE_ID, events_.event(i),
+                        events_.groups_of(i), vsomeip::event_type_e::ET_EVENT,
+                        std::chrono::milliseconds::zero(), false, true,
+                        nullptr,
+                        use_tcp_ ? vsomeip::reliability_type_e::RT_RELIABLE
+                                 : vsomeip::reliability_type_e::RT_UNRELIABLE);
     }
+    std::cout << "Offering " << std::dec << events_.events()
+              << " event(s) in " << events_.eventgroups()
+              << " eventgroup(s), notify "
+              << (notify_all_ ? "all per tick" : "round-robin") << ", "
+              << (use_tcp_ ? "reliable" : "unreliable")
+              << (seq_header_ ? ", with sequence header" : "") << std::endl;
+    if (!use_tcp_ && events_.events() > kTpEvents)
+      std::cerr << "config/publish_subscribe.json enables SOME/IP-TP only for "
+                << "the first " << kTpEvents << " events; larger UDP samples of "
+                << "the others are not segmented" << std::endl;
+    framed_.reserve(sample_header::kSize +
+                    std::max<std::size_t>(kMaxSampleSize, payload_size_));
+    payload_ = vsomeip::runtime::get()->create_payload();
 
     blocked_ = true;
     condition_.notify_one();
@@ -101,6 +173,14 @@ public:
     condition_.notify_one();
     notify_condition_.notify_one();
     app_->clear_all_handler();
+    // notify线程退出前发送剩余的batch，必须在stop_offer之前
+    if (std::this_thread::get_id() != notify_thread_.get_id()) {
+      if (notify_thread_.joinable()) {
+        notify_thread_.join();
+      }
+    } else {
+      notify_thread_.detach();
+    }
     stop_offer();
     if (std::this_thread::get_id() != offer_thread_.get_id()) {
       if (offer_thread_.joinable()) {
@@ -109,13 +189,14 @@ public:
     } else {
       offer_thread_.detach();
     }
-    if (std::this_thread::get_id() != notify_thread_.get_id()) {
-      if (notify_thread_.joinable()) {
-        notify_thread_.join();
+    if (std::this_thread::get_id() != produce_thread_.get_id()) {
+      if (produce_thread_.joinable()) {
+        produce_thread_.join();
       }
     } else {
-      notify_thread_.detach();
+      produce_thread_.detach();
     }
+    print_sample_counters();
     app_->stop();
   }
 
@@ -174,59 +255,357 @@ public:
   }
 
   /**
-   * @brief Notify the event.
+   * @brief Hand a new sample to the notify thread.
+   * @note 无锁，不会等待正在进行的notify；同一时刻只能有一个线程调用
+   * @param _data 样本数据
+   * @param _size 样本长度，超过kMaxSampleSize的部分会分配新内存
    */
-  void notify() {
+  void publish_sample(const vsomeip::byte_t *_data, std::size_t _size) {
+    samples_.write_buffer().assign(_data, _data + _size);
+    samples_.publish();
+  }
 
+  /**
+   * @brief Example producer: publishes samples of growing length.
+   */
+  void produce() {
+    if (payload_size_ > 0) {
+      produce_fixed();
+      return;
+    }
     vsomeip::byte_t its_data[10];
     uint32_t its_size = 1;
+    rate_pacer its_pacer(produce_rate_, 1, std::chrono::microseconds(0));
+
+    while (running_) {
+      its_pacer.wait();
+      if (its_size == sizeof(its_data))
+        its_size = 1;
+
+      for (uint32_t i = 0; i < its_size; ++i)
+        its_data[i] = static_cast<uint8_t>(i);
+
+      publish_sample(its_data, its_size);
+      its_size++;
+    }
+  }
+
+  /**
+   * @brief Example producer for large payloads: samples of payload_size_ bytes
+   * @note 直接写入triple_buffer的写缓冲区；每个缓冲区只在第一次使用时填充，
+   * 之后只更新开头4字节的计数(大端)，生成样本的开销与长度无关
+   * @note 缓冲区预先按max(kMaxSampleSize, payload_size_)构造，长度不能说明
+   * 是否已填充，因此按地址记录填充过的缓冲区
+   */
+  void produce_fixed() {
+    uint32_t its_counter = 0;
+    rate_pacer its_pacer(produce_rate_, 1, std::chrono::microseconds(0));
+    std::vector<const vsomeip::byte_t *> its_filled;
+
+    while (running_) {
+      its_pacer.wait();
+      std::vector<vsomeip::byte_t> &its_sample = samples_.write_buffer();
+      its_sample.resize(payload_size_);
+      if (std::find(its_filled.begin(), its_filled.end(), its_sample.data()) ==
+          its_filled.end()) {
+        for (std::size_t i = 0; i < its_sample.size(); ++i)
+          its_sample[i] = static_cast<vsomeip::byte_t>(i);
+        its_filled.push_back(its_sample.data());
+      }
+      its_counter++;
+      for (std::size_t i = 0; i < 4 && i < its_sample.size(); ++i)
+        its_sample[i] =
+            static_cast<vsomeip::byte_t>(its_counter >> (24 - 8 * i));
+      samples_.publish();
+    }
+  }
+
+  /**
+   * @brief Notify the event.
+   */
+  void notify() {
+    if (rate_ > 0)
+      notify_paced();
+    else
+      notify_cycle();
+    flush_all();
+  }
 
+  /**
+   * @brief Notify the event every cycle_ ms.
+   * @note 每个周期发送生产者最新发布的样本，没有新样本时不发送
+   * @note 打包时在最早的batch截止时间提前醒来，不等下一个样本就发送超时的batch
+   */
+  void notify_cycle() {
     while (running_) {
       std::unique_lock<std::mutex> its_lock(notify_mutex_);
       while (!is_offered_ && running_)
         notify_condition_.wait(its_lock);
+      auto its_next_cycle = std::chrono::steady_clock::now();
       while (is_offered_ && running_) {
-        if (its_size == sizeof(its_data))
-          its_size = 1;
-
-        for (uint32_t i = 0; i < its_size; ++i)
-          its_data[i] = static_cast<uint8_t>(i);
-
-        {
-          std::lock_guard<std::mutex> its_lock(payload_mutex_);
-          payload_->set_data(its_data, its_size);
-
-          std::cout << "Notify event (Length=" << std::dec << its_size << ")."
-                    << std::endl;
-
-          /**
-           * @brief Notify the event.
-           * @note
-           * 特定的event通过特定的payload来传递数据。根据不通的事件类型，将payload分发给相关的订阅者(event一直会发送，filed只会在payload发生变化时才会发送)。
-           * @note 在使用该接口之前，需要先调用offer_event接口
-           *
-           * @param _service 服务ID
-           * @param _instance 实例ID
-           * @param _event 事件ID
-           * @param _payload vsemeip::payload对象，包含了需要传递的数据
-           * @param _force 是否强制发送，默认为false
-           */
-          app_->notify(PublishSubscribe_SERVICE_ID,
-                       PublishSubscribe_INSTANCE_ID, PublishSubscribe_EVENT_ID,
-                       payload_);
+        const auto its_now = std::chrono::steady_clock::now();
+        if (its_now >= its_next_cycle) {
+          its_next_cycle = its_now + std::chrono::milliseconds(cycle_);
+          if (samples_.update()) {
+            const std::vector<vsomeip::byte_t> &its_sample =
+                samples_.read_buffer();
+            set_sample(its_sample);
+
+            const uint32_t its_sent = notify_tick();
+            std::cout << "Notify " << std::dec << its_sent
+                      << " event(s) (Length=" << its_sample.size()
+                      << ", overwritten samples=" << samples_.overwritten()
+                      << ")." << std::endl;
+          }
         }
+        if (!batches_.empty())
+          flush_overdue();
 
-        its_size++;
+        notify_condition_.wait_until(its_lock, next_wakeup(its_next_cycle));
+      }
+    }
+  }
+
+  /**
+   * @brief Notify the event at rate_ msgs/s using absolute deadlines.
+   * @note 每个截止时间发送最新的样本；生产者没有更新时重复发送上一个样本
+   * @note 每秒输出一次实际速率和调度抖动，不再逐条打印
+   */
+  void notify_paced() {
+    rate_pacer its_pacer(rate_, burst_, std::chrono::microseconds(spin_us_));
+    // 每个截止时间内所有notify调用的耗时
+    latency_histogram its_notify_cost;
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(cycle_));
+    while (running_) {
+      std::unique_lock<std::mutex> its_lock(notify_mutex_);
+      while (!is_offered_ && running_)
+        notify_condition_.wait(its_lock);
+      its_pacer.reset();
+      while (is_offered_ && running_) {
+        its_pacer.wait();
+        const auto its_start = std::chrono::steady_clock::now();
+        uint32_t its_sent = 0;
+        for (uint32_t i = 0; i < its_pacer.burst(); ++i) {
+          if (samples_.update()) {
+            set_sample(samples_.read_buffer());
+          }
+          its_sent += notify_tick();
+        }
+        its_notify_cost.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - its_start)
+                .count()));
+        its_pacer.sent(its_sent);
+        if (its_pacer.is_report_due(std::chrono::seconds(1))) {
+          its_pacer.report(std::cout);
+          std::cout << "Notify cost per tick (" << std::dec
+                    << events_.events() << " event(s), "
+                    << (notify_all_ ? "all" : "round-robin") << ") ";
+          its_notify_cost.print(std::cout);
+          std::cout << std::endl;
+          its_notify_cost.reset();
+          print_sample_counters();
+        }
       }
     }
   }
 
 private:
+  void print_sample_counters() {
+    std::cout << "Samples published: " << std::dec << samples_.published()
+              << ", overwritten before notify: " << samples_.overwritten();
+    if (use_shm_)
+      std::cout << ", shm written: " << shm_.written()
+                << ", no free slot: " << shm_.exhausted();
+    if (!batches_.empty())
+      std::cout << ", batches: " << batches_sent_ << " (samples/batch="
+                << (batches_sent_ ? double(batched_samples_) / batches_sent_
+                                  : 0.0)
+                << ", flushed by count=" << flushed_full_
+                << " bytes=" << flushed_bytes_ << " delay=" << flushed_delay_
+                << " stop=" << flushed_stop_ << ")";
+    std::cout << std::endl;
+  }
+
+  /// 每个event一个encoder，_count不大于1时不打包
+  static std::vector<batch_codec::encoder>
+  make_batches(uint32_t _count, uint32_t _events, uint32_t _bytes,
+               uint32_t _delay_us) {
+    std::vector<batch_codec::encoder> its_batches;
+    if (_count > 1) {
+      its_batches.reserve(_events);
+      for (uint32_t i = 0; i < _events; ++i)
+        its_batches.emplace_back(_count, _bytes,
+                                 std::chrono::microseconds(_delay_us));
+    }
+    return its_batches;
+  }
+
+  /**
+   * @brief Use _sample as the payload of the following notifications.
+   * @note 启用sample_header时先拷贝到framed_，头部在每次notify前填写
+   * @note 启用共享内存时样本写入一个槽位，payload只包含描述符；没有空闲槽位时
+   * 照常发送样本本身
+   */
+  void set_sample(const std::vector<vsomeip::byte_t> &_sample) {
+    const vsomeip::byte_t *its_data = _sample.data();
+    std::size_t its_size = _sample.size();
+    vsomeip::byte_t its_descriptor[shm_descriptor::kSize];
+    shm_descriptor its_slot;
+    if (use_shm_ && shm_.write(its_data, its_size, its_slot)) {
+      its_slot.encode(its_descriptor);
+      its_data = its_descriptor;
+      its_size = sizeof(its_descriptor);
+    }
+
+    if (!seq_header_) {
+      payload_->set_data(its_data, static_cast<vsomeip::length_t>(its_size));
+      return;
+    }
+    framed_.resize(sample_header::kSize + its_size);
+    std::copy(its_data, its_data + its_size,
+              framed_.begin() + sample_header::kSize);
+  }
+
+  /**
+   * @brief Notify the event at _index of events_ with the current sample.
+   */
+  void notify_event(uint32_t _index) {
+    if (seq_header_) {
+      sample_header{++sequences_[_index], sample_header::now()}.encode(
+          framed_.data());
+      if (batches_.empty())
+        payload_->set_data(framed_.data(),
+                           static_cast<vsomeip::length_t>(framed_.size()));
+    }
+    if (!batches_.empty()) {
+      batch_sample(_index);
+      return;
+    }
+    /**
+     * @brief Notify the event.
+     * @note
+     * 特定的event通过特定的payload来传递数据。根据不通的事件类型，将payload分发给相关的订阅者(event一直会发送，filed只会在payload发生变化时才会发送)。
+     * @note 在使用该接口之前，需要先调用offer_event接口
+     *
+     * @param _service 服务ID
+     * @param _instance 实例ID
+     * @param _event 事件ID
+     * @param _payload vsemeip::payload对象，包含了需要传递的数据
+     * @param _force 是否强制发送，默认为false
+     */
+    app_->notify(PublishSubscribe_SERVICE_ID, PublishSubscribe_INSTANCE_ID,
+                 events_.event(_index), payload_);
+  }
+
+  /**
+   * @brief Add the current sample of event _index to its batch
+   * @note 超过字节数上限时先发送已有的batch；达到样本数上限时立即发送
+   */
+  void batch_sample(uint32_t _index) {
+    const vsomeip::byte_t *its_data = seq_header_ ? framed_.data()
+                                                  : payload_->get_data();
+    const std::size_t its_size =
+        seq_header_ ? framed_.size() : payload_->get_length();
+    batch_codec::encoder &its_batch = batches_[_index];
+    if (!its_batch.empty() && its_batch.would_overflow(its_size))
+      flush_batch(_index, flushed_bytes_);
+    its_batch.add(its_data, its_size, std::chrono::steady_clock::now());
+    if (its_batch.is_full())
+      flush_batch(_index, flushed_full_);
+    else if (its_batch.would_overflow(0))
+      flush_batch(_index, flushed_bytes_);
+  }
+
+  /**
+   * @brief Send the batch of event _index and count the reason in _reason
+   */
+  void flush_batch(uint32_t _index, uint64_t &_reason) {
+    batch_codec::encoder &its_batch = batches_[_index];
+    batch_payload_->set_data(its_batch.data(),
+                             static_cast<vsomeip::length_t>(its_batch.size()));
+    app_->notify(PublishSubscribe_SERVICE_ID, PublishSubscribe_INSTANCE_ID,
+                 events_.event(_index), batch_payload_);
+    batches_sent_++;
+    batched_samples_ += its_batch.count();
+    _reason++;
+    its_batch.reset();
+  }
+
+  /// 发送第一个样本已等待超过上限的batch
+  void flush_overdue() {
+    const auto its_now = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < batches_.size(); ++i)
+      if (batches_[i].is_overdue(its_now))
+        flush_batch(i, flushed_delay_);
+  }
+
+  /// 发送所有未满的batch，notify线程退出前调用
+  void flush_all() {
+    for (uint32_t i = 0; i < batches_.size(); ++i)
+      if (!batches_[i].empty())
+        flush_batch(i, flushed_stop_);
+  }
+
+  /// _next_cycle与最早的batch截止时间中较早的一个
+  std::chrono::steady_clock::time_point
+  next_wakeup(std::chrono::steady_clock::time_point _next_cycle) const {
+    for (const batch_codec::encoder &its_batch : batches_)
+      if (!its_batch.empty())
+        _next_cycle = std::min(_next_cycle, its_batch.deadline());
+    return _next_cycle;
+  }
+
+  /**
+   * @brief Notify the next event (round-robin) or all events.
+   * @return 本次发送的notification数，打包时为加入batch的样本数
+   */
+  uint32_t notify_tick() {
+    uint32_t its_sent = events_.events();
+    if (!notify_all_) {
+      notify_event(next_event_);
+      next_event_ = (next_event_ + 1) % events_.events();
+      its_sent = 1;
+    } else {
+      for (uint32_t i = 0; i < events_.events(); ++i)
+        notify_event(i);
+    }
+    if (!batches_.empty())
+      flush_overdue();
+    return its_sent;
+  }
+
   std::shared_ptr<vsomeip::application> app_;
   bool is_registered_;
   uint32_t cycle_;
+  double rate_;
+  uint32_t burst_;
+  uint32_t spin_us_;
+  double produce_rate_;
+  event_range events_;
+  bool notify_all_;
+  /// 轮询模式下一个要notify的event下标，只由notify线程访问
+  uint32_t next_event_;
+  bool seq_header_;
+  bool use_tcp_;
+  /// 示例生产者生成的样本长度，0表示1~9字节
+  uint32_t payload_size_;
+  bool use_shm_;
+  uint32_t shm_slots_;
+  shm_writer shm_;
+  /// 每个event已发送的最大序号，只由notify线程访问
+  std::vector<uint64_t> sequences_;
+  /// sample_header + 当前样本，只由notify线程访问
+  std::vector<vsomeip::byte_t> framed_;
+  /// 每个event的batch，为空表示不打包；以下成员只由notify线程访问
+  std::vector<batch_codec::encoder> batches_;
+  std::shared_ptr<vsomeip::payload> batch_payload_;
+  uint64_t batches_sent_;
+  uint64_t batched_samples_;
+  uint64_t flushed_full_;
+  uint64_t flushed_bytes_;
+  uint64_t flushed_delay_;
+  uint64_t flushed_stop_;
 
   std::mutex mutex_;
   std::condition_variable condition_;
@@ -237,18 +616,56 @@ private:
   std::condition_variable notify_condition_;
   bool is_offered_;
 
-  std::mutex payload_mutex_;
+  /// 样本缓冲区预留的容量
+  static constexpr std::size_t kMaxSampleSize = 1024;
+  /// config/publish_subscribe.json中启用SOME/IP-TP的event数(0x8888-0x88A7)
+  static constexpr uint32_t kTpEvents = 32;
+  /// 只由notify线程访问
   std::shared_ptr<vsomeip::payload> payload_;
+  /// 生产者与notify线程之间传递最新样本
+  triple_buffer<std::vector<vsomeip::byte_t>> samples_;
 
   // blocked_ / is_offered_ must be initialized before starting the threads!
   std::thread offer_thread_;
   std::thread notify_thread_;
+  std::thread produce_thread_;
 };
 
 int main(int argc, char **argv) {
   uint32_t cycle = 1000; // default 1s
+  double rate = 0;       // default: use cycle
+  uint32_t burst = 1;
+  uint32_t spin_us = 0;
+  double produce_rate = 0; // default: same as the publishing rate
+  uint32_t events = 1;
+  uint32_t eventgroups = 1;
+  bool notify_all = false;
+  bool seq_header = false;
+  bool use_tcp = true;
+  uint32_t payload_size = 0; // default: 1~9 bytes
+  bool use_shm = false;
+  uint32_t shm_slots = 16;
+  uint32_t batch_count = 0; // default: no batching
+  uint32_t batch_bytes = 1400;
+  uint32_t batch_delay_us = 200;
 
   std::string cycle_arg("--cycle");
+  std::string rate_arg("--rate");
+  std::string burst_arg("--burst");
+  std::string spin_arg("--spin-us");
+  std::string produce_rate_arg("--produce-rate");
+  std::string events_arg("--events");
+  std::string eventgroups_arg("--eventgroups");
+  std::string notify_mode_arg("--notify-mode"); // rr | all
+  std::string seq_header_arg("--seq-header");
+  std::string udp_arg("--udp");
+  std::string payload_size_arg("--payload-size");
+  std::string shm_arg("--shm");
+  std::string shm_slots_arg("--shm-slots");
+  std::string batch_arg("--batch");
+  std::string batch_count_arg("--batch-count");
+  std::string batch_bytes_arg("--batch-bytes");
+  std::string batch_delay_arg("--batch-delay-us");
 
   for (int i = 1; i < argc; i++) {
     if (cycle_arg == argv[i] && i + 1 < argc) {
@@ -256,10 +673,80 @@ int main(int argc, char **argv) {
       std::stringstream converter;
       converter << argv[i];
       converter >> cycle;
+    } else if (rate_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> rate;
+    } else if (burst_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> burst;
+    } else if (spin_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> spin_us;
+    } else if (produce_rate_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> produce_rate;
+    } else if (events_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> events;
+    } else if (eventgroups_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> eventgroups;
+    } else if (notify_mode_arg == argv[i] && i + 1 < argc) {
+      i++;
+      notify_all = (std::string("all") == argv[i]);
+    } else if (seq_header_arg == argv[i]) {
+      seq_header = true;
+    } else if (udp_arg == argv[i]) {
+      use_tcp = false;
+    } else if (payload_size_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> payload_size;
+    } else if (shm_arg == argv[i]) {
+      use_shm = true;
+    } else if (shm_slots_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> shm_slots;
+    } else if (batch_arg == argv[i]) {
+      if (batch_count == 0)
+        batch_count = 64;
+    } else if (batch_count_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> batch_count;
+    } else if (batch_bytes_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> batch_bytes;
+    } else if (batch_delay_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> batch_delay_us;
     }
   }
 
-  publisher_example its_sample(cycle);
+  publisher_example its_sample(cycle, rate, burst, spin_us, produce_rate,
+                               events, eventgroups, notify_all, seq_header,
+                               use_tcp, payload_size, use_shm, shm_slots,
+                               batch_count, batch_bytes, batch_delay_us);
   if (its_sample.init()) {
     its_sample.start();
     return 0;
@@ -7,55 +7,43 @@
     "Signal handling is disabled. The application will not be able to stop gracefully."
 #include <csignal>
 #endif
-#include <chrono>
-#include <condition_variable>
-#include <iomanip>
-#include <iostream>
 #include <sstream>
-#include <thread>
 
-#include "vsomeip/vsomeip.hpp"
+#include "routing_sample.hpp"
 
-#include "sample_ids.hpp"
-#include "type_map.hpp"
-
-/**
- * @brief This class implements a simple VSOMEIP client that sends a request to
- * a VSOMEIP service.
- */
-class routing_sample {
-public:
-  routing_sample()
-      : app_(vsomeip::runtime::get()->create_application("routing_example")) {}
-
-  bool init() {
-    std::cout << "Routing example Initing!" << std::endl;
-    if (!app_->init()) {
-      std::cerr << "Couldn't initialize application" << std::endl;
-      return false;
+int main(int argc, char **argv) {
+  uint32_t stats_interval = 0; // default: no statistics
+  std::string stats_file;
+  std::string stats_socket;
+
+  std::string stats_interval_arg("--stats-interval");
+  std::string stats_file_arg("--stats-file");
+  std::string stats_socket_arg("--stats-socket");
+
+  for (int i = 1; i < argc; i++) {
+    if (stats_interval_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> stats_interval;
+    } else if (stats_file_arg == argv[i] && i + 1 < argc) {
+      i++;
+      stats_file = argv[i];
+    } else if (stats_socket_arg == argv[i] && i + 1 < argc) {
+      i++;
+      stats_socket = argv[i];
     }
-    std::cout << "Routing example Inited!" << std::endl;
-    std::cout << "App name: " << app_->get_name() << std::endl;
-    return true;
-  }
-
-  void start() { app_->start(); }
-
-  void stop() {
-    app_->clear_all_handler();
-    app_->stop();
   }
+  // 指定了输出位置但没有指定周期时，默认5s
+  if (stats_interval == 0 && (!stats_file.empty() || !stats_socket.empty()))
+    stats_interval = 5000;
 
-private:
-  /// the VSOMEIP application
-  std::shared_ptr<vsomeip::application> app_;
-};
-
-int main(int argc, char **argv) {
-  routing_sample its_sample = routing_sample();
+  routing_sample its_sample(stats_interval, stats_file, stats_socket);
 
   if (its_sample.init()) {
     its_sample.start();
+    // start()在收到信号后返回，结束统计线程
+    its_sample.stop();
     return 0;
   } else {
     return 1;
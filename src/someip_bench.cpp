@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "bench_process.hpp"
+#include "sample_ids.hpp"
+
+/**
+ * @brief 请求/响应的基准测试：在本机回环上启动routing、response和request，
+ * 遍历payload大小、传输协议和在途请求数，把每组参数的吞吐量和延时分位数写入CSV
+ * @note 由config/request_response.json生成两个节点的配置：服务端节点使用
+ * 127.0.0.1，客户端节点使用127.0.0.2。两个节点的network名称不同，各自运行一个
+ * routing，因此请求确实经过TCP/UDP，而不是本地的Unix socket
+ * @note 关闭service discovery，客户端节点根据配置中服务的unicast地址使用静态路由
+ * @note UDP超过一个报文的payload使用SOME/IP-TP分段，CSV中附加各进程的CPU时间，
+ * 用于评估分段/重组的开销
+ * @note local布局在一个节点中运行三个进程，single布局使用all_in_one，两者都经过
+ * 本地通信，CSV的label列区分布局，transport列没有意义
+ */
+
+namespace {
+
+const char *kServerAddress = "127.0.0.1";
+const char *kClientAddress = "127.0.0.2";
+/// 不使用SOME/IP-TP时，一个UDP报文最多携带的payload
+const uint32_t kMaxUdpPayload = 1400;
+/// SOME/IP头部长度
+const uint32_t kHeaderSize = 16;
+/// vsomeip默认的UDP接收缓冲区大小
+const uint32_t kUdpReceiveBuffer = 1703936;
+
+struct bench_options {
+  std::string bin_dir_;
+  std::string template_;
+  std::string work_dir_;
+  std::string output_;
+  std::vector<uint32_t> sizes_;
+  std::vector<std::string> layouts_;
+  std::vector<std::string> transports_;
+  std::vector<uint32_t> inflights_;
+  uint32_t duration_;
+  /// request在duration_之后仍未退出时的额外等待时间，单位s
+  uint32_t grace_;
+  /// 为false时跳过超过kMaxUdpPayload的UDP payload，而不是使用SOME/IP-TP
+  bool use_tp_;
+};
+
+/**
+ * @brief Write the configuration of one node derived from the template
+ * @param _unicast 本节点的地址
+ * @param _network 本节点的network名称，决定本地Unix socket的路径
+ * @param _max_payload 需要支持的最大payload
+ */
+bool write_config(const bench_options &_options, const std::string &_path,
+                  const std::string &_unicast, const std::string &_network,
+                  uint32_t _max_payload) {
+  namespace pt = boost::property_tree;
+  pt::ptree its_config;
+  try {
+    pt::read_json(_options.template_, its_config);
+  } catch (const pt::json_parser_error &e) {
+    std::cerr << "Couldn't read " << _options.template_ << ": " << e.what()
+              << std::endl;
+    return false;
+  }
+
+  its_config.put("unicast", _unicast);
+  its_config.put("network", _network);
+  its_config.put("routing", "routing_example");
+  its_config.put("logging.level", "warning");
+  its_config.put("logging.file.enable", "false");
+  its_config.put("logging.dlt", "false");
+  its_config.put("service-discovery.enable", "false");
+
+  // 两个节点中服务都位于服务端节点；在客户端节点中它因此是远端服务
+  pt::ptree::assoc_iterator its_services = its_config.find("services");
+  if (its_services != its_config.not_found()) {
+    for (auto &its_service : its_services->second)
+      its_service.second.put("unicast", kServerAddress);
+  }
+
+  const std::string its_limit = std::to_string(_max_payload + kHeaderSize);
+  its_config.put("max-payload-size-local", its_limit);
+  its_config.put("max-payload-size-reliable", its_limit);
+
+  if (_options.use_tp_ && _max_payload > kMaxUdpPayload) {
+    // 请求和响应都可能超过一个UDP报文，两个方向都启用SOME/IP-TP。
+    // 一个完整消息的所有分段需要同时放入接收缓冲区
+    its_config.put("max-payload-size-unreliable", its_limit);
+    its_config.put("udp-receive-buffer-size",
+                   std::to_string(std::max(kUdpReceiveBuffer,
+                                           2 * (_max_payload + kHeaderSize))));
+    if (its_services != its_config.not_found()) {
+      for (auto &its_service : its_services->second) {
+        std::stringstream its_id;
+        its_id << "0x" << std::hex << std::setw(4) << std::setfill('0')
+               << RequestResponse_METHOD_ID;
+        pt::ptree its_methods;
+        pt::ptree its_method;
+        its_method.put_value(its_id.str());
+        its_methods.push_back(std::make_pair("", its_method));
+        its_service.second.put_child("someip-tp.client-to-service",
+                                     its_methods);
+        its_service.second.put_child("someip-tp.service-to-client",
+                                     its_methods);
+      }
+    }
+  }
+
+  try {
+    pt::write_json(_path, its_config);
+  } catch (const pt::json_parser_error &e) {
+    std::cerr << "Couldn't write " << _path << ": " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Append the row request wrote to _run to the output, with CPU columns
+ * @param _client_cpu 客户端进程的CPU时间，single布局时为整个进程
+ * @param _server_cpu 服务端进程的CPU时间
+ */
+void append_result(const bench_options &_options, const std::string &_run,
+                   double _client_cpu, double _server_cpu) {
+  std::ifstream its_run(_run);
+  std::string its_header, its_row;
+  if (!std::getline(its_run, its_header) || !std::getline(its_run, its_row))
+    return;
+
+  // 按列名查找responses列，用于计算每个请求的CPU开销
+  uint64_t its_responses = 0;
+  std::stringstream its_names(its_header), its_values(its_row);
+  std::string its_name, its_value;
+  while (std::getline(its_names, its_name, ',') &&
+         std::getline(its_values, its_value, ',')) {
+    if (its_name == "responses") {
+      std::stringstream converter;
+      converter << its_value;
+      converter >> its_responses;
+    }
+  }
+
+  const bool is_new = !std::ifstream(_options.output_).good();
+  std::ofstream its_output(_options.output_, std::ios::app);
+  if (is_new)
+    its_output << its_header
+               << ",cpu_client_s,cpu_server_s,cpu_us_per_request\n";
+  its_output << its_row << "," << std::fixed << std::setprecision(3)
+             << _client_cpu << "," << _server_cpu << ","
+             << (its_responses > 0
+                     ? (_client_cpu + _server_cpu) * 1e6 / its_responses
+                     : 0.0)
+             << "\n";
+}
+
+/**
+ * @brief Run one combination and append its result row to the output
+ * @param _layout network: 两个节点经过回环网络；local: 一个节点三个进程，
+ * 经过Unix socket；single: all_in_one，一个进程
+ * @return false if request did not finish in time
+ */
+bool run_once(const bench_options &_options, const std::string &_layout,
+              const std::string &_transport, uint32_t _size,
+              uint32_t _inflight) {
+  const bool is_network = (_layout == "network");
+  const std::string its_server_config =
+      _options.work_dir_ + (is_network ? "/server.json" : "/local.json");
+  const std::string its_client_config =
+      _options.work_dir_ + (is_network ? "/client.json" : "/local.json");
+  const std::string its_log = _options.work_dir_ + "/bench.log";
+  const std::string its_run = _options.work_dir_ + "/run.csv";
+  const std::string its_size = std::to_string(_size);
+  std::remove(its_run.c_str());
+
+  {
+    std::ofstream its_out(its_log, std::ios::app);
+    its_out << "=== " << _layout << " " << _transport << " payload=" << _size
+            << " inflight=" << _inflight << " ===" << std::endl;
+  }
+
+  std::vector<std::string> its_args = {"--quiet",
+                                       "--payload-size",
+                                       its_size,
+                                       "--inflight",
+                                       std::to_string(_inflight),
+                                       "--duration",
+                                       std::to_string(_options.duration_),
+                                       "--csv",
+                                       its_run,
+                                       "--label",
+                                       _layout};
+  if (_transport == "udp")
+    its_args.push_back("--udp");
+
+  // 除request外的进程，second为true表示属于服务端
+  std::vector<std::pair<pid_t, bool>> its_services;
+  pid_t its_request = -1;
+  if (_layout == "single") {
+    its_request = bench_process::spawn(_options.bin_dir_ + "/all_in_one",
+                                       its_args, its_client_config, its_log);
+  } else {
+    its_services.emplace_back(
+        bench_process::spawn(_options.bin_dir_ + "/routing", {},
+                             its_server_config, its_log),
+        true);
+    if (is_network)
+      its_services.emplace_back(
+          bench_process::spawn(_options.bin_dir_ + "/routing", {},
+                               its_client_config, its_log),
+          false);
+    // routing必须先于应用启动，否则应用会自己成为routing host
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    its_services.emplace_back(
+        bench_process::spawn(
+            _options.bin_dir_ + "/response",
+            {"--quiet", "--static-routing", "--payload-size", its_size},
+            its_server_config, its_log),
+        true);
+    its_request = bench_process::spawn(_options.bin_dir_ + "/request",
+                                       its_args, its_client_config, its_log);
+  }
+
+  double its_client_cpu = 0, its_server_cpu = 0;
+  bool is_finished = true;
+  if (its_request > 0 &&
+      !bench_process::wait_for(
+          its_request,
+          std::chrono::seconds(_options.duration_ + _options.grace_),
+          its_client_cpu)) {
+    std::cerr << "request did not finish, see " << its_log << std::endl;
+    bench_process::terminate(its_request, its_client_cpu);
+    is_finished = false;
+  }
+  // 与启动顺序相反：先停止应用，再停止routing
+  for (auto its_pid = its_services.rbegin(); its_pid != its_services.rend();
+       ++its_pid)
+    bench_process::terminate(its_pid->first,
+                             its_pid->second ? its_server_cpu : its_client_cpu);
+
+  if (is_finished)
+    append_result(_options, its_run, its_client_cpu, its_server_cpu);
+  return is_finished && its_request > 0;
+}
+
+void print_usage(const char *_name) {
+  std::cout
+      << "Usage: " << _name << " [options]\n"
+      << "  --bin-dir DIR       directory of routing/request/response "
+         "(default: directory of this program)\n"
+      << "  --config FILE       template configuration "
+         "(default: config/request_response.json)\n"
+      << "  --work-dir DIR      generated configurations and logs "
+         "(default: /tmp/someip_bench)\n"
+      << "  --output FILE       result CSV, truncated at start "
+         "(default: someip_bench.csv)\n"
+      << "  --sizes LIST        payload sizes in bytes "
+         "(default: 10,100,1000,10000,100000,1000000,4000000)\n"
+      << "  --layouts LIST      network, local and/or single "
+         "(default: network,local,single)\n"
+      << "  --transports LIST   tcp and/or udp for the network layout "
+         "(default: tcp,udp)\n"
+      << "  --inflight LIST     requests in flight (default: 1,8,64)\n"
+      << "  --duration S        seconds per combination (default: 5)\n"
+      << "  --grace S           extra seconds before a run is killed "
+         "(default: 15)\n"
+      << "  --no-tp             skip udp payloads above " << kMaxUdpPayload
+      << " bytes instead of using SOME/IP-TP\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench_options its_options;
+  its_options.bin_dir_ = bench_process::executable_dir();
+  its_options.template_ = "config/request_response.json";
+  its_options.work_dir_ = "/tmp/someip_bench";
+  its_options.output_ = "someip_bench.csv";
+  its_options.sizes_ = {10, 100, 1000, 10000, 100000, 1000000, 4000000};
+  its_options.layouts_ = {"network", "local", "single"};
+  its_options.transports_ = {"tcp", "udp"};
+  its_options.inflights_ = {1, 8, 64};
+  its_options.duration_ = 5;
+  its_options.grace_ = 15;
+  its_options.use_tp_ = true;
+
+  std::string bin_dir_arg("--bin-dir");
+  std::string config_arg("--config");
+  std::string work_dir_arg("--work-dir");
+  std::string output_arg("--output");
+  std::string sizes_arg("--sizes");
+  std::string layouts_arg("--layouts");
+  std::string transports_arg("--transports");
+  std::string inflight_arg("--inflight");
+  std::string duration_arg("--duration");
+  std::string grace_arg("--grace");
+  std::string no_tp_arg("--no-tp");
+  std::string help_arg("--help");
+
+  for (int i = 1; i < argc; i++) {
+    if (help_arg == argv[i]) {
+      print_usage(argv[0]);
+      return 0;
+    } else if (no_tp_arg == argv[i]) {
+      its_options.use_tp_ = false;
+    } else if (bin_dir_arg == argv[i] && i + 1 < argc) {
+      its_options.bin_dir_ = argv[++i];
+    } else if (config_arg == argv[i] && i + 1 < argc) {
+      its_options.template_ = argv[++i];
+    } else if (work_dir_arg == argv[i] && i + 1 < argc) {
+      its_options.work_dir_ = argv[++i];
+    } else if (output_arg == argv[i] && i + 1 < argc) {
+      its_options.output_ = argv[++i];
+    } else if (sizes_arg == argv[i] && i + 1 < argc) {
+      its_options.sizes_ = bench_process::parse_list<uint32_t>(argv[++i]);
+    } else if (layouts_arg == argv[i] && i + 1 < argc) {
+      its_options.layouts_ =
+          bench_process::parse_list<std::string>(argv[++i]);
+    } else if (transports_arg == argv[i] && i + 1 < argc) {
+      its_options.transports_ =
+          bench_process::parse_list<std::string>(argv[++i]);
+    } else if (inflight_arg == argv[i] && i + 1 < argc) {
+      its_options.inflights_ = bench_process::parse_list<uint32_t>(argv[++i]);
+    } else if (duration_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> its_options.duration_;
+    } else if (grace_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> its_options.grace_;
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+  if (its_options.duration_ == 0)
+    its_options.duration_ = 1;
+
+  // request只追加结果，由这里负责清空上一次的输出
+  if (mkdir(its_options.work_dir_.c_str(), 0755) < 0 && errno != EEXIST) {
+    std::cerr << "Couldn't create " << its_options.work_dir_ << ": "
+              << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  std::remove(its_options.output_.c_str());
+
+  uint32_t its_max_payload = 0;
+  for (uint32_t its_size : its_options.sizes_)
+    its_max_payload = std::max(its_max_payload, its_size);
+  if (!write_config(its_options, its_options.work_dir_ + "/server.json",
+                    kServerAddress, "vsomeip_bench_server", its_max_payload) ||
+      !write_config(its_options, its_options.work_dir_ + "/client.json",
+                    kClientAddress, "vsomeip_bench_client", its_max_payload) ||
+      !write_config(its_options, its_options.work_dir_ + "/local.json",
+                    kServerAddress, "vsomeip_bench_local", its_max_payload))
+    return 1;
+
+  for (const std::string &its_layout : its_options.layouts_) {
+    if (its_layout != "network" && its_layout != "local" &&
+        its_layout != "single") {
+      std::cerr << "Unknown layout " << its_layout << std::endl;
+      return 1;
+    }
+  }
+  for (const std::string &its_transport : its_options.transports_) {
+    if (its_transport != "tcp" && its_transport != "udp") {
+      std::cerr << "Unknown transport " << its_transport << std::endl;
+      return 1;
+    }
+  }
+
+  uint32_t its_failed = 0;
+  for (const std::string &its_layout : its_options.layouts_) {
+    // 本地通信不经过TCP/UDP，只运行一次
+    const std::vector<std::string> its_transports =
+        its_layout == "network" ? its_options.transports_
+                                : std::vector<std::string>{"tcp"};
+    for (const std::string &its_transport : its_transports) {
+      for (uint32_t its_size : its_options.sizes_) {
+        if (its_transport == "udp" && its_size > kMaxUdpPayload &&
+            !its_options.use_tp_) {
+          // 更大的payload需要SOME/IP-TP分段
+          std::cerr << "Skipping udp payload=" << its_size << ", limit is "
+                    << kMaxUdpPayload << " bytes without SOME/IP-TP"
+                    << std::endl;
+          continue;
+        }
+        for (uint32_t its_inflight : its_options.inflights_) {
+          std::cerr << its_layout << " " << its_transport
+                    << " payload=" << its_size << " inflight=" << its_inflight
+                    << std::endl;
+          if (!run_once(its_options, its_layout, its_transport, its_size,
+                        std::max<uint32_t>(its_inflight, 1)))
+            its_failed++;
+        }
+      }
+    }
+  }
+
+  std::ifstream its_result(its_options.output_);
+  std::cout << its_result.rdbuf();
+  if (its_failed > 0)
+    std::cerr << its_failed << " runs did not finish" << std::endl;
+  return its_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "bench_process.hpp"
+
+/**
+ * @brief 启动时间扫描：遍历service discovery的参数，在本机回环上反复冷启动
+ * routing、response和request，统计request从创建到服务可用、到第一个响应的
+ * 时间分布
+ * @note 由config/request_response.json生成两个节点的配置：服务端节点使用
+ * 127.0.0.1并提供服务，客户端节点使用127.0.0.2，只能通过SD发现服务。
+ * SD的多播需要经过lo，例如：ip route add 224.0.0.0/4 dev lo
+ * @note 每次试验先启动两个routing，--routing-delay之后同时启动response和
+ * request，模拟上电后服务端和客户端同时启动
+ * @note 每次试验的原始结果写入work_dir/trials.csv，每组参数的分位数写入--output
+ */
+
+namespace {
+
+const char *kServerAddress = "127.0.0.1";
+const char *kClientAddress = "127.0.0.2";
+
+/// 一组service discovery参数，单位ms
+struct sd_parameters {
+  uint32_t initial_delay_min_;
+  uint32_t initial_delay_max_;
+  uint32_t repetitions_base_delay_;
+  uint32_t cyclic_offer_delay_;
+};
+
+struct sweep_options {
+  std::string bin_dir_;
+  std::string template_;
+  std::string work_dir_;
+  std::string output_;
+  std::vector<uint32_t> initial_delay_min_;
+  std::vector<uint32_t> initial_delay_max_;
+  std::vector<uint32_t> repetitions_base_delay_;
+  std::vector<uint32_t> cyclic_offer_delay_;
+  uint32_t trials_;
+  /// routing启动后等待多久再启动应用，单位ms
+  uint32_t routing_delay_;
+  /// 一次试验最多等待的时间，单位s
+  uint32_t timeout_;
+};
+
+/**
+ * @brief Write the configuration of one node derived from the template
+ * @param _is_server 服务端节点提供服务；客户端节点的配置中没有服务，
+ * 只能通过SD找到它
+ */
+bool write_config(const sweep_options &_options, const std::string &_path,
+                  const std::string &_unicast, const std::string &_network,
+                  bool _is_server, const sd_parameters &_sd) {
+  namespace pt = boost::property_tree;
+  pt::ptree its_config;
+  try {
+    pt::read_json(_options.template_, its_config);
+  } catch (const pt::json_parser_error &e) {
+    std::cerr << "Couldn't read " << _options.template_ << ": " << e.what()
+              << std::endl;
+    return false;
+  }
+
+  its_config.put("unicast", _unicast);
+  its_config.put("network", _network);
+  its_config.put("routing", "routing_example");
+  its_config.put("logging.level", "warning");
+  its_config.put("logging.file.enable", "false");
+  its_config.put("logging.dlt", "false");
+  its_config.put("service-discovery.enable", "true");
+  its_config.put("service-discovery.initial_delay_min",
+                 std::to_string(_sd.initial_delay_min_));
+  its_config.put("service-discovery.initial_delay_max",
+                 std::to_string(_sd.initial_delay_max_));
+  its_config.put("service-discovery.repetitions_base_delay",
+                 std::to_string(_sd.repetitions_base_delay_));
+  its_config.put("service-discovery.cyclic_offer_delay",
+                 std::to_string(_sd.cyclic_offer_delay_));
+
+  pt::ptree::assoc_iterator its_services = its_config.find("services");
+  if (its_services != its_config.not_found()) {
+    if (_is_server) {
+      for (auto &its_service : its_services->second)
+        its_service.second.put("unicast", kServerAddress);
+    } else {
+      its_config.erase(its_config.to_iterator(its_services));
+    }
+  }
+
+  try {
+    pt::write_json(_path, its_config);
+  } catch (const pt::json_parser_error &e) {
+    std::cerr << "Couldn't write " << _path << ": " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// 一次试验中request记录的时间，单位ms
+struct trial_result {
+  double registered_;
+  double available_;
+  double first_response_;
+};
+
+/**
+ * @brief Cold start routing, response and request once
+ * @return false if request did not get a response before the timeout
+ */
+bool run_trial(const sweep_options &_options, const std::string &_label,
+               trial_result &_result) {
+  const std::string its_server_config = _options.work_dir_ + "/server.json";
+  const std::string its_client_config = _options.work_dir_ + "/client.json";
+  const std::string its_log = _options.work_dir_ + "/sweep.log";
+  const std::string its_trial = _options.work_dir_ + "/trial.csv";
+  std::remove(its_trial.c_str());
+
+  std::vector<pid_t> its_processes;
+  its_processes.push_back(bench_process::spawn(
+      _options.bin_dir_ + "/routing", {}, its_server_config, its_log));
+  its_processes.push_back(bench_process::spawn(
+      _options.bin_dir_ + "/routing", {}, its_client_config, its_log));
+  // routing必须先于应用启动，否则应用会自己成为routing host
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(_options.routing_delay_));
+  its_processes.push_back(bench_process::spawn(_options.bin_dir_ + "/response",
+                                               {"--quiet"}, its_server_config,
+                                               its_log));
+  const pid_t its_request = bench_process::spawn(
+      _options.bin_dir_ + "/request",
+      {"--quiet", "--inflight", "1", "--startup-only", "--startup-csv",
+       its_trial, "--label", _label},
+      its_client_config, its_log);
+
+  double its_cpu = 0;
+  bool is_finished =
+      its_request > 0 &&
+      bench_process::wait_for(its_request,
+                              std::chrono::seconds(_options.timeout_), its_cpu);
+  if (!is_finished)
+    bench_process::terminate(its_request, its_cpu);
+  for (auto its_pid = its_processes.rbegin(); its_pid != its_processes.rend();
+       ++its_pid)
+    bench_process::terminate(*its_pid, its_cpu);
+
+  std::ifstream its_csv(its_trial);
+  std::string its_header, its_row;
+  if (!std::getline(its_csv, its_header) || !std::getline(its_csv, its_row))
+    return false;
+  _result.registered_ =
+      bench_process::csv_column(its_header, its_row, "registered_ms");
+  _result.available_ =
+      bench_process::csv_column(its_header, its_row, "available_ms");
+  _result.first_response_ =
+      bench_process::csv_column(its_header, its_row, "first_response_ms");
+
+  const std::string its_trials_path = _options.work_dir_ + "/trials.csv";
+  const bool is_new = !std::ifstream(its_trials_path).good();
+  std::ofstream its_trials(its_trials_path, std::ios::app);
+  if (is_new)
+    its_trials << its_header << "\n";
+  its_trials << its_row << "\n";
+  return _result.first_response_ >= 0;
+}
+
+/// 已排序的_values的第_percent百分位(最近秩)
+double percentile(const std::vector<double> &_values, double _percent) {
+  if (_values.empty())
+    return -1;
+  std::size_t its_rank = static_cast<std::size_t>(
+      std::ceil(_percent / 100.0 * static_cast<double>(_values.size())));
+  its_rank = std::min(std::max<std::size_t>(its_rank, 1), _values.size());
+  return _values[its_rank - 1];
+}
+
+void write_distribution(std::ostream &_out, std::vector<double> _values) {
+  std::sort(_values.begin(), _values.end());
+  _out << "," << percentile(_values, 0) << "," << percentile(_values, 50)
+       << "," << percentile(_values, 90) << "," << percentile(_values, 99)
+       << "," << (_values.empty() ? -1 : _values.back());
+}
+
+/**
+ * @brief Run all trials of one parameter set and append its summary row
+ * @return number of failed trials
+ */
+uint32_t run_parameters(const sweep_options &_options,
+                        const sd_parameters &_sd) {
+  std::stringstream its_label;
+  its_label << _sd.initial_delay_min_ << "-" << _sd.initial_delay_max_ << "/"
+            << _sd.repetitions_base_delay_ << "/" << _sd.cyclic_offer_delay_;
+  if (!write_config(_options, _options.work_dir_ + "/server.json",
+                    kServerAddress, "vsomeip_sweep_server", true, _sd) ||
+      !write_config(_options, _options.work_dir_ + "/client.json",
+                    kClientAddress, "vsomeip_sweep_client", false, _sd))
+    return _options.trials_;
+
+  std::vector<double> its_registered, its_available, its_first_response;
+  uint32_t its_failed = 0;
+  for (uint32_t i = 0; i < _options.trials_; ++i) {
+    trial_result its_result;
+    if (!run_trial(_options, its_label.str(), its_result)) {
+      its_failed++;
+      continue;
+    }
+    its_registered.push_back(its_result.registered_);
+    its_available.push_back(its_result.available_);
+    its_first_response.push_back(its_result.first_response_);
+  }
+
+  const bool is_new = !std::ifstream(_options.output_).good();
+  std::ofstream its_output(_options.output_, std::ios::app);
+  if (is_new) {
+    its_output << "initial_delay_min,initial_delay_max,repetitions_base_delay,"
+                  "cyclic_offer_delay,trials,failed";
+    for (const char *its_phase :
+         {"registered", "available", "first_response"})
+      for (const char *its_stat : {"min", "p50", "p90", "p99", "max"})
+        its_output << "," << its_phase << "_" << its_stat << "_ms";
+    its_output << "\n";
+  }
+  its_output << _sd.initial_delay_min_ << "," << _sd.initial_delay_max_ << ","
+             << _sd.repetitions_base_delay_ << "," << _sd.cyclic_offer_delay_
+             << "," << _options.trials_ << "," << its_failed << std::fixed
+             << std::setprecision(3);
+  write_distribution(its_output, its_registered);
+  write_distribution(its_output, its_available);
+  write_distribution(its_output, its_first_response);
+  its_output << "\n";
+
+  std::sort(its_first_response.begin(), its_first_response.end());
+  std::cerr << its_label.str() << ": first response p50="
+            << percentile(its_first_response, 50)
+            << "ms p99=" << percentile(its_first_response, 99)
+            << "ms, failed " << its_failed << "/" << _options.trials_
+            << std::endl;
+  return its_failed;
+}
+
+void print_usage(const char *_name) {
+  std::cout
+      << "Usage: " << _name << " [options]\n"
+      << "  --bin-dir DIR                  directory of routing/request/"
+         "response (default: directory of this program)\n"
+      << "  --config FILE                  template configuration "
+         "(default: config/request_response.json)\n"
+      << "  --work-dir DIR                 generated configurations and logs "
+         "(default: /tmp/startup_sweep)\n"
+      << "  --output FILE                  summary CSV, truncated at start "
+         "(default: startup_sweep.csv)\n"
+      << "  --initial-delay-min LIST       ms (default: 0,10)\n"
+      << "  --initial-delay-max LIST       ms (default: 10,100)\n"
+      << "  --repetitions-base-delay LIST  ms (default: 10,200)\n"
+      << "  --cyclic-offer-delay LIST      ms (default: 1000,2000)\n"
+      << "  --trials N                     cold starts per parameter set "
+         "(default: 20)\n"
+      << "  --routing-delay MS             wait after starting routing "
+         "(default: 200)\n"
+      << "  --timeout S                    seconds before a trial fails "
+         "(default: 10)\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  sweep_options its_options;
+  its_options.bin_dir_ = bench_process::executable_dir();
+  its_options.template_ = "config/request_response.json";
+  its_options.work_dir_ = "/tmp/startup_sweep";
+  its_options.output_ = "startup_sweep.csv";
+  its_options.initial_delay_min_ = {0, 10};
+  its_options.initial_delay_max_ = {10, 100};
+  its_options.repetitions_base_delay_ = {10, 200};
+  its_options.cyclic_offer_delay_ = {1000, 2000};
+  its_options.trials_ = 20;
+  its_options.routing_delay_ = 200;
+  its_options.timeout_ = 10;
+
+  std::string bin_dir_arg("--bin-dir");
+  std::string config_arg("--config");
+  std::string work_dir_arg("--work-dir");
+  std::string output_arg("--output");
+  std::string initial_delay_min_arg("--initial-delay-min");
+  std::string initial_delay_max_arg("--initial-delay-max");
+  std::string repetitions_base_delay_arg("--repetitions-base-delay");
+  std::string cyclic_offer_delay_arg("--cyclic-offer-delay");
+  std::string trials_arg("--trials");
+  std::string routing_delay_arg("--routing-delay");
+  std::string timeout_arg("--timeout");
+  std::string help_arg("--help");
+
+  for (int i = 1; i < argc; i++) {
+    uint32_t *its_number = nullptr;
+    std::vector<uint32_t> *its_list = nullptr;
+    if (help_arg == argv[i]) {
+      print_usage(argv[0]);
+      return 0;
+    } else if (bin_dir_arg == argv[i] && i + 1 < argc) {
+      its_options.bin_dir_ = argv[++i];
+    } else if (config_arg == argv[i] && i + 1 < argc) {
+      its_options.template_ = argv[++i];
+    } else if (work_dir_arg == argv[i] && i + 1 < argc) {
+      its_options.work_dir_ = argv[++i];
+    } else if (output_arg == argv[i] && i + 1 < argc) {
+      its_options.output_ = argv[++i];
+    } else if (initial_delay_min_arg == argv[i] && i + 1 < argc) {
+      its_list = &its_options.initial_delay_min_;
+    } else if (initial_delay_max_arg == argv[i] && i + 1 < argc) {
+      its_list = &its_options.initial_delay_max_;
+    } else if (repetitions_base_delay_arg == argv[i] && i + 1 < argc) {
+      its_list = &its_options.repetitions_base_delay_;
+    } else if (cyclic_offer_delay_arg == argv[i] && i + 1 < argc) {
+      its_list = &its_options.cyclic_offer_delay_;
+    } else if (trials_arg == argv[i] && i + 1 < argc) {
+      its_number = &its_options.trials_;
+    } else if (routing_delay_arg == argv[i] && i + 1 < argc) {
+      its_number = &its_options.routing_delay_;
+    } else if (timeout_arg == argv[i] && i + 1 < argc) {
+      its_number = &its_options.timeout_;
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+    if (its_list)
+      *its_list = bench_process::parse_list<uint32_t>(argv[++i]);
+    if (its_number) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> *its_number;
+    }
+  }
+
+  if (mkdir(its_options.work_dir_.c_str(), 0755) < 0 && errno != EEXIST) {
+    std::cerr << "Couldn't create " << its_options.work_dir_ << ": "
+              << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  std::remove(its_options.output_.c_str());
+  std::remove((its_options.work_dir_ + "/trials.csv").c_str());
+
+  uint32_t its_failed = 0;
+  for (uint32_t its_min : its_options.initial_delay_min_)
+    for (uint32_t its_max : its_options.initial_delay_max_) {
+      // vsomeip要求initial_delay_min不大于initial_delay_max
+      if (its_min > its_max)
+        continue;
+      for (uint32_t its_repetitions : its_options.repetitions_base_delay_)
+        for (uint32_t its_cyclic : its_options.cyclic_offer_delay_)
+          its_failed += run_parameters(
+              its_options, {its_min, its_max, its_repetitions, its_cyclic});
+    }
+
+  std::ifstream its_result(its_options.output_);
+  std::cout << its_result.rdbuf();
+  if (its_failed > 0)
+    std::cerr << its_failed << " trials did not get a response" << std::endl;
+  return its_failed > 0 ? 1 : 0;
+}
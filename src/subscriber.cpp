@@ -9,12 +9,22 @@
 #include <condition_variable>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include <vsomeip/vsomeip.hpp>
 
+#include "async_logger.hpp"
+#include "batch_codec.hpp"
+#include "event_range.hpp"
+#include "message_formatter.hpp"
+#include "sample_header.hpp"
 #include "sample_ids.hpp"
+#include "sequence_tracker.hpp"
+#include "shm_channel.hpp"
 #include "type_map.hpp"
 
 /**
@@ -25,10 +35,29 @@ public:
   /**
    * @brief Construct the subscribe example.
    * @param _use_tcp Use TCP or not.
+   * @param _events 订阅的event数，与publisher的--events一致
+   * @param _eventgroups event分布到的eventgroup数，与publisher的--eventgroups一致
+   * @param _seq_header 按sample_header解析payload，统计丢包、乱序和单向延时
+   * @param _use_shm payload(sample_header之后)为shm_descriptor时，
+   * 直接从共享内存读取数据，与publisher的--shm一致
+   * @param _batch payload为batch_codec打包的多个样本，与publisher的--batch一致
    */
-  subscribe_example(bool _use_tcp)
+  subscribe_example(bool _use_tcp, uint32_t _events = 1,
+                    uint32_t _eventgroups = 1, bool _seq_header = false,
+                    bool _use_shm = false, bool _batch = false)
       : app_(vsomeip::runtime::get()->create_application("subscribe_example")),
-        use_tcp_(_use_tcp) {}
+        use_tcp_(_use_tcp),
+        events_(PublishSubscribe_EVENT_ID, _events,
+                PublishSubscribe_EVENTGROUP_ID, _eventgroups),
+        seq_header_(_seq_header), use_shm_(_use_shm), batch_(_batch),
+        received_(0), received_bytes_(0), batches_(0),
+        malformed_(0), per_event_(new std::atomic<uint64_t>[events_.events()]),
+        trackers_(_seq_header ? events_.events() : 0), last_received_(0),
+        last_received_bytes_(0),
+        last_report_(std::chrono::steady_clock::now()) {
+    for (uint32_t i = 0; i < events_.events(); ++i)
+      per_event_[i] = 0;
+  }
 
   /**
    * @brief Initialize the subscribe example.
@@ -53,8 +82,6 @@ public:
                   std::placeholders::_1, std::placeholders::_2,
                   std::placeholders::_3));
 
-    std::set<vsomeip::eventgroup_t> its_groups;
-    its_groups.insert(PublishSubscribe_EVENTGROUP_ID);
     /**
      * @brief
      * app需要调用改方法从而接受event或者field，改方法会在routing中进行注册
@@ -66,9 +93,12 @@ public:
      * @param _reliability
      * 可靠性类型，默认为RT_UNKNOWN。设计上不是RT_UNRELIABLE，就是RT_RELIABLE。并且同一个eventgroup中的event需要可靠性类型一致
      */
-    app_->request_event(PublishSubscribe_SERVICE_ID,
-                        PublishSubscribe_INSTANCE_ID, PublishSubscribe_EVENT_ID,
-                        its_groups, vsomeip::event_type_e::ET_EVENT);
+    for (uint32_t i = 0; i < events_.events(); ++i) {
+      app_->request_event(PublishSubscribe_SERVICE_ID,
+                          PublishSubscribe_INSTANCE_ID, events_.event(i),
+                          events_.groups_of(i),
+                          vsomeip::event_type_e::ET_EVENT);
+    }
 
     /**
      * @brief 订阅服务
@@ -81,8 +111,10 @@ public:
      * @param _major 服务的Major版本号，默认为DEFAULT_MAJOR
      * @param _event 事件ID，默认为ANY_EVENT,表示订阅所有事件
      */
-    app_->subscribe(PublishSubscribe_SERVICE_ID, PublishSubscribe_INSTANCE_ID,
-                    PublishSubscribe_EVENTGROUP_ID);
+    for (uint32_t i = 0; i < events_.eventgroups(); ++i) {
+      app_->subscribe(PublishSubscribe_SERVICE_ID,
+                      PublishSubscribe_INSTANCE_ID, events_.eventgroup(i));
+    }
 
     return true;
   }
@@ -104,8 +136,10 @@ public:
      * @param _instance 实例ID
      * @param _eventgroup 事件组ID
      */
-    app_->unsubscribe(PublishSubscribe_SERVICE_ID, PublishSubscribe_INSTANCE_ID,
-                      PublishSubscribe_EVENTGROUP_ID);
+    for (uint32_t i = 0; i < events_.eventgroups(); ++i) {
+      app_->unsubscribe(PublishSubscribe_SERVICE_ID,
+                        PublishSubscribe_INSTANCE_ID, events_.eventgroup(i));
+    }
     /**
      * @brief 从vsomeip routing中注销当前app之前注册的event
      *
@@ -113,11 +147,16 @@ public:
      * @param _instance 实例ID
      * @param _event 事件ID
      */
-    app_->release_event(PublishSubscribe_SERVICE_ID,
-                        PublishSubscribe_INSTANCE_ID,
-                        PublishSubscribe_EVENT_ID);
+    for (uint32_t i = 0; i < events_.events(); ++i) {
+      app_->release_event(PublishSubscribe_SERVICE_ID,
+                          PublishSubscribe_INSTANCE_ID, events_.event(i));
+    }
     app_->release_service(PublishSubscribe_SERVICE_ID,
                           PublishSubscribe_INSTANCE_ID);
+    {
+      std::lock_guard<std::mutex> its_lock(report_mutex_);
+      report(std::chrono::steady_clock::now());
+    }
     app_->stop();
   }
 
@@ -145,9 +184,9 @@ public:
    */
   void on_availability(vsomeip::service_t _service,
                        vsomeip::instance_t _instance, bool _is_available) {
-    std::cout << "Service [" << std::hex << std::setfill('0') << std::setw(4)
-              << _service << "." << _instance << "] is "
-              << (_is_available ? "available." : "NOT available.") << std::endl;
+    message_formatter its_formatter;
+    its_formatter.append_availability(_service, _instance, _is_available);
+    std::cout << its_formatter.view() << std::endl;
   }
 
   /**
@@ -155,53 +194,197 @@ public:
    * @param _response Message.
    */
   void on_message(const std::shared_ptr<vsomeip::message> &_response) {
-    std::stringstream ss;
-    ss << "Received a notify from "
-       << "service: " << std::hex << std::setfill('0') << std::setw(4)
-       << _response->get_service() << ", instance: " << std::hex
-       << std::setfill('0') << std::setw(4) << _response->get_instance()
-       << ", client: " << std::hex << std::setfill('0') << std::setw(4)
-       << _response->get_client() << ", method: " << std::hex
-       << std::setfill('0') << std::setw(4) << _response->get_method()
-       << ", message: " << _response->get_message()
-       << ", length: " << _response->get_length()
-       << ", request: " << _response->get_request()
-       << ", session: " << _response->get_session()
-       << ", protocol version: " << _response->get_protocol_version()
-       << ", interface version: " << _response->get_interface_version()
-       << ", message type: " << message_map.at(_response->get_message_type())
-       << ", return code: " << return_code_map.at(_response->get_return_code())
-       << ", is reliable: " << _response->is_reliable()
-       << ", is valid crc: " << _response->is_valid_crc();
-    std::cout << ss.str() << std::endl;
-
-    std::stringstream its_message;
-    its_message << "Received a notification for Event [" << std::hex
-                << std::setfill('0') << std::setw(4) << _response->get_service()
-                << "." << std::setw(4) << _response->get_instance() << "."
-                << std::setw(4) << _response->get_method()
-                << "] to Client/Session [" << std::setw(4)
-                << _response->get_client() << "/" << std::setw(4)
-                << _response->get_session() << "] = ";
-
+    async_logger::get().log_message(log_level_e::LL_INFO,
+                                    "Received a notification from", _response,
+                                    true);
+    const uint64_t its_now = sample_header::now();
     std::shared_ptr<vsomeip::payload> its_payload = _response->get_payload();
-    its_message << "(" << std::dec << its_payload->get_length() << ") "
-                << std::hex;
-    for (uint32_t i = 0; i < its_payload->get_length(); ++i)
-      its_message << std::setw(2)
-                  << static_cast<int>(its_payload->get_data()[i]) << " ";
-    std::cout << its_message.str() << std::endl;
+    const uint32_t its_index = events_.index_of(_response->get_method());
+    if (batch_) {
+      batches_.fetch_add(1, std::memory_order_relaxed);
+      if (!batch_codec::for_each(
+              its_payload->get_data(), its_payload->get_length(),
+              [this, its_index, its_now](const vsomeip::byte_t *_data,
+                                         std::size_t _size) {
+                on_sample(its_index, _data, _size, its_now);
+              }))
+        malformed_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      on_sample(its_index, its_payload->get_data(), its_payload->get_length(),
+                its_now);
+    }
+    report_if_due();
   }
 
 private:
+  /**
+   * @brief Account one sample of the event with index _index
+   * @param _now 收到notification的时间，batch中的样本使用同一个时间
+   */
+  void on_sample(uint32_t _index, const vsomeip::byte_t *_data,
+                 std::size_t _size, uint64_t _now) {
+    std::size_t its_length = _size;
+    // 在处理结束前持有共享内存槽位的引用
+    shm_lease its_lease;
+    if (use_shm_) {
+      const std::size_t its_offset = seq_header_ ? sample_header::kSize : 0;
+      shm_descriptor its_descriptor;
+      if (_size >= its_offset &&
+          shm_descriptor::decode(_data + its_offset, _size - its_offset,
+                                 its_descriptor)) {
+        // 数据就在its_lease.data()中，这里只统计长度
+        its_lease = shm_reader_.pin(its_descriptor);
+        if (its_lease)
+          its_length = its_offset + its_lease.size();
+      }
+    }
+    received_.fetch_add(1, std::memory_order_relaxed);
+    received_bytes_.fetch_add(its_length, std::memory_order_relaxed);
+    if (_index < events_.events()) {
+      per_event_[_index].fetch_add(1, std::memory_order_relaxed);
+      if (seq_header_) {
+        sample_header its_header;
+        if (sample_header::decode(_data, _size, its_header)) {
+          std::lock_guard<std::mutex> its_lock(trackers_mutex_);
+          trackers_[_index].on_sample(its_header, _now, its_length);
+        } else {
+          malformed_.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Print the receive rate once per second
+   * @note 可能有多个dispatcher线程同时调用，只有拿到锁的线程输出
+   */
+  void report_if_due() {
+    const auto its_now = std::chrono::steady_clock::now();
+    if (its_now - last_report_.load(std::memory_order_relaxed) <
+        std::chrono::seconds(1))
+      return;
+    std::unique_lock<std::mutex> its_lock(report_mutex_, std::try_to_lock);
+    if (its_lock.owns_lock() &&
+        its_now - last_report_.load() >= std::chrono::seconds(1))
+      report(its_now);
+  }
+
+  /// 调用者必须持有report_mutex_
+  void report(std::chrono::steady_clock::time_point _now) {
+    const uint64_t its_received = received_.load(std::memory_order_relaxed);
+    const double its_seconds =
+        std::chrono::duration<double>(_now - last_report_.load()).count();
+    uint32_t its_seen = 0;
+    for (uint32_t i = 0; i < events_.events(); ++i)
+      if (per_event_[i].load(std::memory_order_relaxed) > 0)
+        its_seen++;
+    const uint64_t its_bytes = received_bytes_.load(std::memory_order_relaxed);
+    const uint64_t its_rate =
+        its_seconds > 0 ? static_cast<uint64_t>(
+                              (its_received - last_received_) / its_seconds)
+                        : 0;
+    const double its_mb_rate =
+        its_seconds > 0 ? (its_bytes - last_received_bytes_) / its_seconds / 1e6
+                        : 0.0;
+    const std::ios_base::fmtflags its_flags = std::cout.flags();
+    const std::streamsize its_precision = std::cout.precision();
+    std::cout << "Received " << std::dec << its_rate
+              << (batch_ ? " samples/s, " : " notifications/s, ")
+              << std::fixed << std::setprecision(3) << its_mb_rate
+              << " MB/s, total=" << its_received << ", events seen "
+              << its_seen << "/" << events_.events();
+    if (use_shm_)
+      std::cout << ", shm stale=" << shm_reader_.stale();
+    if (batch_)
+      std::cout << ", batches=" << batches_.load(std::memory_order_relaxed);
+    std::cout << std::endl;
+    std::cout.flags(its_flags);
+    std::cout.precision(its_precision);
+    if (seq_header_) {
+      sequence_stats its_stats;
+      {
+        std::lock_guard<std::mutex> its_lock(trackers_mutex_);
+        for (sequence_tracker &its_tracker : trackers_) {
+          its_stats.merge(its_tracker.stats());
+          its_tracker.reset_latency();
+        }
+      }
+      std::cout << "Sequence: ";
+      its_stats.print(std::cout);
+      std::cout << " malformed=" << malformed_.load(std::memory_order_relaxed)
+                << std::endl;
+    }
+    last_received_ = its_received;
+    last_received_bytes_ = its_bytes;
+    last_report_ = _now;
+  }
+
   std::shared_ptr<vsomeip::application> app_;
   bool use_tcp_;
+  event_range events_;
+  bool seq_header_;
+  bool use_shm_;
+  bool batch_;
+  shm_reader shm_reader_;
+
+  /// 收到的样本数，打包时一个notification包含多个样本
+  std::atomic<uint64_t> received_;
+  std::atomic<uint64_t> received_bytes_;
+  std::atomic<uint64_t> batches_;
+  /// 启用sample_header时长度不足的payload数，以及无法解析的batch数
+  std::atomic<uint64_t> malformed_;
+  /// 每个event收到的notification数，下标为event_range中的下标
+  std::unique_ptr<std::atomic<uint64_t>[]> per_event_;
+  /// 每个event一个，只在持有trackers_mutex_时访问
+  std::mutex trackers_mutex_;
+  std::vector<sequence_tracker> trackers_;
+  /// 以下成员只在持有report_mutex_时修改
+  std::mutex report_mutex_;
+  uint64_t last_received_;
+  uint64_t last_received_bytes_;
+  std::atomic<std::chrono::steady_clock::time_point> last_report_;
 };
 
 int main(int argc, char **argv) {
   bool use_tcp = true;
 
-  subscribe_example its_sample(use_tcp);
+  uint32_t events = 1;
+  uint32_t eventgroups = 1;
+  bool seq_header = false;
+  bool use_shm = false;
+  bool batch = false;
+
+  std::string quiet_arg("--quiet");
+  std::string shm_arg("--shm");
+  std::string batch_arg("--batch");
+  std::string seq_header_arg("--seq-header");
+  std::string events_arg("--events");
+  std::string eventgroups_arg("--eventgroups");
+
+  for (int i = 1; i < argc; i++) {
+    if (quiet_arg == argv[i]) {
+      async_logger::get().set_level(log_level_e::LL_WARNING);
+    } else if (seq_header_arg == argv[i]) {
+      seq_header = true;
+    } else if (shm_arg == argv[i]) {
+      use_shm = true;
+    } else if (batch_arg == argv[i]) {
+      batch = true;
+    } else if (events_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> events;
+    } else if (eventgroups_arg == argv[i] && i + 1 < argc) {
+      i++;
+      std::stringstream converter;
+      converter << argv[i];
+      converter >> eventgroups;
+    }
+  }
+
+  subscribe_example its_sample(use_tcp, events, eventgroups, seq_header,
+                               use_shm, batch);
   if (its_sample.init()) {
     its_sample.start();
     return 0;